@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "alx.hpp"
+using namespace alx;
+
+
+//percent of the images that are copies of an earlier image
+static const int duplicatePercent = 10;
+
+
+//an image to pack
+struct Image {
+    int width, height;
+    int id;
+};
+
+
+//creates the images of a run; duplicates repeat the size and content of an earlier image
+std::vector<Image> makeImages(int count, int minSize, int maxSize) {
+    std::vector<Image> images;
+    for(int i = 0; i < count; ++i) {
+        if (i > 0 && rand() % 100 < duplicatePercent) {
+            images.push_back(images[rand() % i]);
+        }
+        else {
+            Image image = {minSize + rand() % (maxSize - minSize + 1), minSize + rand() % (maxSize - minSize + 1), i};
+            images.push_back(image);
+        }
+    }
+    return images;
+}
+
+
+//creates a bitmap with contents unique to the image id
+Bitmap makeBitmap(const Image &image) {
+    Bitmap bitmap(image.width, image.height);
+    bitmap.setTarget();
+    al_clear_to_color(Color(image.id & 255, (image.id >> 8) & 255, 255 - (image.id & 255)));
+    return bitmap;
+}
+
+
+//packs one set of images and prints the results
+void run(const char *name, int count, int minSize, int maxSize) {
+    std::vector<Image> images = makeImages(count, minSize, maxSize);
+    std::vector<Bitmap> bitmaps;
+    for(const Image &image : images) {
+        bitmaps.push_back(makeBitmap(image));
+    }
+
+    TextureAtlas atlas;
+    double start = al_get_time();
+    for(const Bitmap &bitmap : bitmaps) {
+        atlas.add(bitmap);
+    }
+    double added = al_get_time();
+    atlas.build();
+    double built = al_get_time();
+
+    printf("%-8s %6i images %4i-%-4i px: add %8.2f ms, build %8.2f ms, %3u pages, %5.1f%% packed, %u duplicates\n",
+        name, count, minSize, maxSize,
+        (added - start) * 1000, (built - added) * 1000,
+        (unsigned)atlas.getPages().size(), atlas.getPackingEfficiency() * 100, (unsigned)atlas.getDuplicateCount());
+}
+
+
+//main
+int main() {
+    al_init();
+
+    //sources and pages are memory bitmaps, so no display is needed
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+    srand(1);
+    run("icons", 1000, 16, 32);
+    run("icons", 4000, 16, 32);
+    run("sprites", 1000, 16, 128);
+    run("sprites", 4000, 16, 128);
+    run("tiles", 2000, 64, 64);
+    run("mixed", 3000, 8, 256);
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "alx.hpp"
+using namespace alx;
+
+
+//benchmark parameters; the colors fit in the cache, as a frame's worth of particle or vertex colors would
+static const size_t colorCount = 8192;
+static const int passCount = 2000;
+
+
+//names of the SIMD levels
+static const char *simdNames[] = {"scalar", "SSE2", "AVX2"};
+
+
+//runs a function a few times and returns the average time per color, in nanoseconds
+template <class F> double measure(F f) {
+    f();
+    double start = al_get_time();
+    for(int i = 0; i < passCount; ++i) {
+        f();
+    }
+    return (al_get_time() - start) * 1e9 / passCount / colorCount;
+}
+
+
+//checks that the converted colors are exactly the ones of al_map_rgba
+bool check(const std::vector<ALLEGRO_COLOR> &result, const std::vector<ALLEGRO_COLOR> &expected) {
+    return memcmp(result.data(), expected.data(), expected.size() * sizeof(ALLEGRO_COLOR)) == 0;
+}
+
+
+//main
+int main() {
+    al_init();
+
+    srand(1);
+    std::vector<Color> colors;
+    for(size_t i = 0; i < colorCount; ++i) {
+        colors.push_back(Color(rand() % 256, rand() % 256, rand() % 256, rand() % 256));
+    }
+    std::vector<ALLEGRO_COLOR> expected(colorCount), result(colorCount);
+
+    printf("converting %u colors, average of %i passes\n", (unsigned)colorCount, passCount);
+
+    //the conversion Color used before the lookup table
+    double mapped = measure([&]() {
+        for(size_t i = 0; i < colorCount; ++i) {
+            const Color &c = colors[i];
+            expected[i] = al_map_rgba(c.getRed(), c.getGreen(), c.getBlue(), c.getAlpha());
+        }
+    });
+    printf("%-30s %6.2f ns/color\n", "al_map_rgba", mapped);
+
+    double single = measure([&]() {
+        for(size_t i = 0; i < colorCount; ++i) {
+            result[i] = colors[i];
+        }
+    });
+    printf("%-30s %6.2f ns/color, %s\n", "Color::operator ALLEGRO_COLOR", single, check(result, expected) ? "same results" : "DIFFERENT RESULTS");
+
+    for(int level = Cpu::Scalar; level <= Cpu::AVX2; ++level) {
+        Cpu::setSimdLevel((Cpu::SimdLevel)level);
+        if (Cpu::getSimdLevel() != level) break;
+        memset(result.data(), 0, result.size() * sizeof(ALLEGRO_COLOR));
+        double bulk = measure([&]() { Color::convert(colors.data(), result.data(), colorCount); });
+        printf("Color::convert, %-15s %6.2f ns/color, %s\n", simdNames[level], bulk, check(result, expected) ? "same results" : "DIFFERENT RESULTS");
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <functional>
+#include "alx.hpp"
+using namespace alx;
+
+
+//screen parameters
+static const int screenWidth = 1920;
+static const int screenHeight = 1080;
+static const int frameCount = 600;
+
+
+//an invalidation pattern; adds the rectangles changed in a frame
+struct Pattern {
+    const char *name;
+    std::function<void(int frame, std::vector<Rect<int>> &rects)> invalidate;
+};
+
+
+//a region setup
+struct Setup {
+    const char *name;
+    size_t maxRects;
+    int64_t mergeCost;
+};
+
+
+//returns a rectangle of the given position and size
+Rect<int> rect(int x, int y, int w, int h) {
+    return Rect<int>(Point<int>(x, y), Size<int>(w, h));
+}
+
+
+//main
+int main() {
+    al_init();
+
+    //fixed widget positions for the patterns that need them
+    srand(1);
+    std::vector<Point<int>> spinners, particles;
+    for(int i = 0; i < 20; ++i) {
+        spinners.push_back(Point<int>(rand() % (screenWidth - 32), rand() % (screenHeight - 32)));
+    }
+    for(int i = 0; i < 50; ++i) {
+        particles.push_back(Point<int>(rand() % screenWidth, rand() % screenHeight));
+    }
+
+    const Pattern patterns[] = {
+        //a text cursor blinking in an edit box
+        {"cursor blink", [](int frame, std::vector<Rect<int>> &rects) {
+            if (frame % 30 == 0) rects.push_back(rect(400, 300, 2, 20));
+        }},
+
+        //the mouse moving along a toolbar; the old and new hovered buttons change
+        {"toolbar hover", [](int frame, std::vector<Rect<int>> &rects) {
+            int button = (frame / 10) % 12;
+            rects.push_back(rect(8 + button * 40, 8, 36, 36));
+            rects.push_back(rect(8 + ((button + 11) % 12) * 40, 8, 36, 36));
+        }},
+
+        //a tooltip following the mouse; its old and new places overlap
+        {"moving tooltip", [](int frame, std::vector<Rect<int>> &rects) {
+            int x = 200 + (frame * 3) % 1200, y = 500 + (int)(100 * std::sin(frame * 0.05));
+            rects.push_back(rect(x - 3, y - 5, 240, 60));
+            rects.push_back(rect(x, y, 240, 60));
+        }},
+
+        //a progress bar growing and a label next to it
+        {"progress bar", [](int frame, std::vector<Rect<int>> &rects) {
+            rects.push_back(rect(660 + frame, 600, 2, 24));
+            rects.push_back(rect(1270, 600, 60, 24));
+        }},
+
+        //a scrolling list panel, fully changed every frame
+        {"scrolling list", [](int, std::vector<Rect<int>> &rects) {
+            rects.push_back(rect(40, 80, 400, 900));
+        }},
+
+        //20 animated spinners scattered over the screen
+        {"20 spinners", [&spinners](int, std::vector<Rect<int>> &rects) {
+            for(const Point<int> &pt : spinners) {
+                rects.push_back(Rect<int>(pt, Size<int>(32, 32)));
+            }
+        }},
+
+        //50 small sprites drifting right, each invalidating its old and new place
+        {"50 particles", [&particles](int frame, std::vector<Rect<int>> &rects) {
+            for(const Point<int> &pt : particles) {
+                int x = (pt.getX() + frame * 2) % screenWidth;
+                rects.push_back(rect(x - 2, pt.getY(), 16, 16));
+                rects.push_back(rect(x, pt.getY(), 16, 16));
+            }
+        }}
+    };
+
+    const Setup setups[] = {
+        {"bounding box", 1, 0},
+        {"no merging", 1024, -1},
+        {"default", 16, 4096},
+        {"max 64, cost 1024", 64, 1024}
+    };
+
+    const double screenPixels = (double)screenWidth * screenHeight;
+    printf("%ix%i screen, %i frames; pixels touched per frame, also as percent of a full redraw\n", screenWidth, screenHeight, frameCount);
+    printf("%-16s %-18s %10s %8s %8s %10s\n", "pattern", "region", "pixels", "percent", "rects", "us/frame");
+    std::vector<Rect<int>> rects;
+    for(const Pattern &pattern : patterns) {
+        for(const Setup &setup : setups) {
+            DirtyRegion region(rect(0, 0, screenWidth, screenHeight), setup.maxRects, setup.mergeCost);
+            double pixels = 0, passes = 0, seconds = 0;
+            for(int frame = 0; frame < frameCount; ++frame) {
+                rects.clear();
+                pattern.invalidate(frame, rects);
+                double start = al_get_time();
+                for(const Rect<int> &r : rects) {
+                    region.add(r);
+                }
+                seconds += al_get_time() - start;
+                pixels += (double)region.getArea();
+                passes += region.getRects().size();
+                region.clear();
+            }
+            printf("%-16s %-18s %10.0f %7.2f%% %8.2f %10.2f\n", pattern.name, setup.name,
+                pixels / frameCount, pixels / frameCount / screenPixels * 100, passes / frameCount, seconds / frameCount * 1e6);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "alx.hpp"
+using namespace alx;
+
+
+//scene parameters
+static const int panelCount = 2000;
+static const int frameCount = 10;
+static const int targetWidth = 1920;
+static const int targetHeight = 1080;
+
+//skin parameters
+static const int skinSize = 48;
+static const int border = 12;
+
+
+//a panel of the scene
+struct Panel {
+    int skin;
+    float x, y, w, h;
+};
+
+
+//returns a random float in [a, b)
+float rnd(float a, float b) {
+    return a + (b - a) * rand() / ((float)RAND_MAX + 1);
+}
+
+
+//draws a panel with nine Bitmap::drawScaled calls, as done without NinePatch
+void drawSlices(Bitmap &bitmap, const Panel &p) {
+    const float s[4] = {0, border, skinSize - border, skinSize};
+    const float dx[4] = {p.x, p.x + border, p.x + p.w - border, p.x + p.w};
+    const float dy[4] = {p.y, p.y + border, p.y + p.h - border, p.y + p.h};
+    for(int row = 0; row < 3; ++row) {
+        for(int col = 0; col < 3; ++col) {
+            bitmap.drawScaled(s[col], s[row], s[col + 1] - s[col], s[row + 1] - s[row], dx[col], dy[row], dx[col + 1] - dx[col], dy[row + 1] - dy[row]);
+        }
+    }
+}
+
+
+//runs the given frame function and returns the average time per frame, in milliseconds
+template <class F> double measure(F frame) {
+    frame();
+    double start = al_get_time();
+    for(int i = 0; i < frameCount; ++i) {
+        frame();
+    }
+    return (al_get_time() - start) * 1000 / frameCount;
+}
+
+
+//main
+int main() {
+    al_init();
+    al_init_primitives_addon();
+
+    //everything lives in memory, so no display is needed
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    Bitmap target(targetWidth, targetHeight);
+
+    //two panel skins on one sheet, with a lighter border and a darker center
+    Bitmap sheet(skinSize * 2, skinSize);
+    sheet.setTarget();
+    al_clear_to_color(Color(200, 200, 220));
+    al_draw_filled_rectangle(border, border, skinSize - border, skinSize - border, Color(60, 60, 80));
+    al_draw_filled_rectangle(skinSize + border, border, skinSize * 2 - border, skinSize - border, Color(80, 40, 40));
+    Bitmap skins[] = {Bitmap(sheet, 0, 0, skinSize, skinSize), Bitmap(sheet, skinSize, 0, skinSize, skinSize)};
+    NinePatch stretched[] = {NinePatch(skins[0], border, border, border, border), NinePatch(skins[1], border, border, border, border)};
+    NinePatch tiled[] = {NinePatch(skins[0], border, border, border, border, true), NinePatch(skins[1], border, border, border, border, true)};
+
+    //the scene
+    srand(1);
+    std::vector<Panel> panels(panelCount);
+    for(Panel &p : panels) {
+        p.skin = rand() % 2;
+        p.w = rnd(64, 400);
+        p.h = rnd(32, 200);
+        p.x = rnd(0, targetWidth - p.w);
+        p.y = rnd(0, targetHeight - p.h);
+    }
+
+    target.setTarget();
+    SpriteBatch batch(true, panelCount * 9);
+    size_t quads = 0, calls = 0;
+
+    double slices = measure([&]() {
+        for(const Panel &p : panels) drawSlices(skins[p.skin], p);
+    });
+    double perPanel = measure([&]() {
+        for(const Panel &p : panels) stretched[p.skin].draw(p.x, p.y, p.w, p.h);
+    });
+    double emit = measure([&]() {
+        for(const Panel &p : panels) stretched[p.skin].draw(batch, p.x, p.y, p.w, p.h);
+        batch.clear();
+    });
+    double batched = measure([&]() {
+        for(const Panel &p : panels) stretched[p.skin].draw(batch, p.x, p.y, p.w, p.h);
+        quads = batch.getSpriteCount();
+        batch.flush();
+        calls = batch.getDrawCallCount();
+    });
+    printf("%i panels of 64-400 x 32-200 px on a %ix%i memory bitmap, %i frames\n", panelCount, targetWidth, targetHeight, frameCount);
+    printf("%-36s %8.2f ms/frame\n", "nine Bitmap::drawScaled per panel", slices);
+    printf("%-36s %8.2f ms/frame\n", "NinePatch::draw per panel", perPanel);
+    printf("%-36s %8.2f ms/frame, %u quads, %u draw calls; emitting alone %.2f ms\n", "NinePatch into a SpriteBatch", batched, (unsigned)quads, (unsigned)calls, emit);
+    double tiledTime = measure([&]() {
+        for(const Panel &p : panels) tiled[p.skin].draw(batch, p.x, p.y, p.w, p.h);
+        quads = batch.getSpriteCount();
+        batch.flush();
+        calls = batch.getDrawCallCount();
+    });
+    printf("%-36s %8.2f ms/frame, %u quads, %u draw calls\n", "tiled NinePatch into a SpriteBatch", tiledTime, (unsigned)quads, (unsigned)calls);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "alx.hpp"
+using namespace alx;
+
+
+//image parameters
+static const int imageWidth = 3840;
+static const int imageHeight = 2160;
+static const int runCount = 3;
+
+
+//a named pipeline setup
+struct Setup {
+    const char *name;
+    void (*build)(ImagePipeline &pipeline);
+};
+
+
+//the color grade used by the benchmark: a slight warm tint with a contrast boost
+static const float gradeMatrix[12] = {
+    1.10f, 0.05f, 0.00f, -0.05f,
+    0.00f, 1.05f, 0.00f, -0.02f,
+    0.00f, 0.05f, 0.95f,  0.00f
+};
+
+
+//pipeline setups
+static const Setup setups[] = {
+    {"blur r=2", [](ImagePipeline &p) { p.addBlur(2); }},
+    {"sharpen", [](ImagePipeline &p) { p.addSharpen(0.5f); }},
+    {"outline", [](ImagePipeline &p) { p.addOutline(al_map_rgb(0, 0, 0)); }},
+    {"color grade", [](ImagePipeline &p) { p.addColorGrade(gradeMatrix); }},
+    {"blur+sharpen+outline+grade", [](ImagePipeline &p) { p.addBlur(2).addSharpen(0.5f).addOutline(al_map_rgb(0, 0, 0)).addColorGrade(gradeMatrix); }}
+};
+
+
+//copies the source pixels into the image, so that every run processes the same input
+void restore(const ImagePipeline::Image &image, const std::vector<uint8_t> &source) {
+    for(int y = 0; y < image.height; ++y) {
+        memcpy(image.getRow(y), &source[y * image.width * 4], image.width * 4);
+    }
+}
+
+
+//main
+int main(int argc, char **argv) {
+    al_init();
+
+    //the maximum thread count defaults to the number of cpus
+    int maxThreads = argc > 1 ? atoi(argv[1]) : al_get_cpu_count();
+    if (maxThreads < 1) maxThreads = 1;
+
+    //a 4K memory bitmap in the pipeline's format, so that locking does not convert
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+    Bitmap bitmap(imageWidth, imageHeight);
+    Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READWRITE);
+    ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+    ImagePipeline::Image image = {static_cast<uint8_t *>(region->data), imageWidth, imageHeight, region->pitch};
+
+    //noisy source with transparent areas, so that the outline stage has edges to find
+    std::vector<uint8_t> source(imageWidth * imageHeight * 4);
+    srand(1);
+    for(size_t i = 0; i < source.size(); i += 4) {
+        source[i    ] = (uint8_t)rand();
+        source[i + 1] = (uint8_t)rand();
+        source[i + 2] = (uint8_t)rand();
+        source[i + 3] = rand() % 4 ? 255 : 0;
+    }
+
+    printf("%ix%i ABGR_8888_LE memory bitmap, 128x128 tiles, best of %i runs\n", imageWidth, imageHeight, runCount);
+    for(const Setup &setup : setups) {
+        printf("%s\n", setup.name);
+        double single = 0;
+        for(int threads = 1; threads <= maxThreads; ++threads) {
+            ImagePipeline pipeline(threads);
+            setup.build(pipeline);
+            double best = 1e9;
+            for(int i = 0; i < runCount; ++i) {
+                restore(image, source);
+                double start = al_get_time();
+                pipeline.run(image);
+                best = std::min(best, al_get_time() - start);
+            }
+            if (threads == 1) single = best;
+            printf("  %2i threads: %8.2f ms %8.1f Mpixels/s, speedup %.2fx\n", threads, best * 1000, imageWidth * (double)imageHeight / best / 1e6, single / best);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <cstdlib>
+#include "alx.hpp"
+using namespace alx;
+
+
+//image parameters
+static const int imageWidth = 2048;
+static const int imageHeight = 2048;
+static const int passCount = 5;
+
+
+//scan result; the sum of the color components, compared between methods
+typedef uint64_t Checksum;
+
+
+//scans with one getPixel call per pixel, without locking
+Checksum scanGetPixel(Bitmap &bitmap) {
+    Checksum sum = 0;
+    for(int y = 0; y < bitmap.getHeight(); ++y) {
+        for(int x = 0; x < bitmap.getWidth(); ++x) {
+            unsigned char r, g, b, a;
+            al_unmap_rgba(bitmap.getPixel(x, y), &r, &g, &b, &a);
+            sum += r + g + b + a;
+        }
+    }
+    return sum;
+}
+
+
+//scans with one getPixel call per pixel inside a lock, the fastest use of getPixel
+Checksum scanGetPixelLocked(Bitmap &bitmap) {
+    Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ANY, ALLEGRO_LOCK_READONLY);
+    return scanGetPixel(bitmap);
+}
+
+
+//scans through a typed view, addressing each pixel by coordinates
+template <class F> Checksum scanView(Bitmap &bitmap) {
+    Bitmap::Lock lock(bitmap, F::Format, ALLEGRO_LOCK_READONLY);
+    PixelView<F> view(lock);
+    Checksum sum = 0;
+    for(int y = 0; y < view.getHeight(); ++y) {
+        for(int x = 0; x < view.getWidth(); ++x) {
+            typename F::Pixel p = view(x, y);
+            sum += F::getRed(p) + F::getGreen(p) + F::getBlue(p) + F::getAlpha(p);
+        }
+    }
+    return sum;
+}
+
+
+//scans through a typed view, row by row
+template <class F> Checksum scanViewRows(Bitmap &bitmap) {
+    Bitmap::Lock lock(bitmap, F::Format, ALLEGRO_LOCK_READONLY);
+    PixelView<F> view(lock);
+    Checksum sum = 0;
+    view.forEachRow([&](const typename F::Pixel *row, int width, int) {
+        uint32_t rowSum = 0;
+        for(int x = 0; x < width; ++x) {
+            typename F::Pixel p = row[x];
+            rowSum += F::getRed(p) + F::getGreen(p) + F::getBlue(p) + F::getAlpha(p);
+        }
+        sum += rowSum;
+    });
+    return sum;
+}
+
+
+//runs a scan a few times, prints the throughput, and returns the checksum
+template <class F> Checksum measure(const char *name, F scan) {
+    Checksum sum = scan();
+    double start = al_get_time();
+    for(int i = 0; i < passCount; ++i) {
+        scan();
+    }
+    double seconds = (al_get_time() - start) / passCount;
+    printf("%-40s %8.2f ms %10.1f Mpixels/s\n", name, seconds * 1000, imageWidth * (double)imageHeight / seconds / 1e6);
+    return sum;
+}
+
+
+//main
+int main() {
+    al_init();
+
+    //a memory bitmap filled with noise, so that no method can skip work
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ARGB_8888);
+    Bitmap bitmap(imageWidth, imageHeight);
+    {
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
+        PixelView<PixelFormat::ARGB_8888> view(lock);
+        view.forEachPixel([](uint32_t &p) { p = ((uint32_t)rand() << 16) ^ (uint32_t)rand(); });
+    }
+
+    printf("full scan of a %ix%i ARGB_8888 memory bitmap, average of %i passes\n", imageWidth, imageHeight, passCount);
+    Checksum expected = measure("Bitmap::getPixel", [&]() { return scanGetPixel(bitmap); });
+    Checksum sums[] = {
+        measure("Bitmap::getPixel, locked", [&]() { return scanGetPixelLocked(bitmap); }),
+        measure("PixelView<ARGB_8888>(x, y)", [&]() { return scanView<PixelFormat::ARGB_8888>(bitmap); }),
+        measure("PixelView<ARGB_8888>::forEachRow", [&]() { return scanViewRows<PixelFormat::ARGB_8888>(bitmap); }),
+        measure("PixelView<ABGR_8888_LE>::forEachRow", [&]() { return scanViewRows<PixelFormat::ABGR_8888_LE>(bitmap); })
+    };
+
+    //every method must have read the same pixels
+    for(Checksum sum : sums) {
+        if (sum != expected) {
+            printf("checksum mismatch\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
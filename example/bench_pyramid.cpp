@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "alx.hpp"
+using namespace alx;
+
+
+//image parameters
+static const int imageSize = 2048;
+static const int passCount = 5;
+
+
+//names of the SIMD levels
+static const char *simdNames[] = {"scalar", "SSE2", "AVX2"};
+
+
+//runs a function a few times and returns the average time, in seconds
+template <class F> double measure(F f) {
+    f();
+    double start = al_get_time();
+    for(int i = 0; i < passCount; ++i) {
+        f();
+    }
+    return (al_get_time() - start) / passCount;
+}
+
+
+//calls a function once per SIMD level supported by the processor
+template <class F> void forEachSimdLevel(F f) {
+    for(int level = Cpu::Scalar; level <= Cpu::AVX2; ++level) {
+        Cpu::setSimdLevel((Cpu::SimdLevel)level);
+        if (Cpu::getSimdLevel() != level) break;
+        f(simdNames[level]);
+    }
+    Cpu::setSimdLevel(Cpu::AVX2);
+}
+
+
+//measures the halving kernels on plain buffers
+void benchKernels() {
+    const int n = imageSize / 2;
+    std::vector<uint32_t> src(imageSize * 2), dst(n);
+    std::vector<float> rows(12 * n * 4);
+    std::vector<uint8_t> out(n * 4);
+    for(uint32_t &p : src) p = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    for(float &f : rows) f = (float)(rand() % 256);
+    const float *rowPtrs[12];
+    for(int k = 0; k < 12; ++k) rowPtrs[k] = &rows[k * n * 4];
+    float w[12] = {-0.01f, 0.02f, -0.05f, 0.1f, 0.2f, 0.24f, 0.24f, 0.2f, 0.1f, -0.05f, 0.02f, -0.01f};
+
+    printf("halving kernels, %i destination pixels per row, %i rows\n", n, n);
+    forEachSimdLevel([&](const char *name) {
+        double box = measure([&]() {
+            for(int y = 0; y < n; ++y) {
+                BitmapPyramid::boxRow(dst.data(), src.data(), src.data() + imageSize, n);
+            }
+        });
+        double lanczos = measure([&]() {
+            for(int y = 0; y < n; ++y) {
+                BitmapPyramid::lanczosColumn(out.data(), rowPtrs, w, n);
+            }
+        });
+        printf("  %-6s boxRow %8.2f ms %8.1f Mpixels/s, lanczosColumn %8.2f ms %8.1f Mpixels/s\n", name,
+            box * 1000, (double)n * n / box / 1e6, lanczos * 1000, (double)n * n / lanczos / 1e6);
+    });
+}
+
+
+//measures building the pyramid of a memory bitmap
+void benchBuild(const Bitmap &bitmap) {
+    printf("pyramid of a %ix%i memory bitmap\n", imageSize, imageSize);
+    forEachSimdLevel([&](const char *name) {
+        BitmapPyramid pyramid;
+        double box = measure([&]() { pyramid.build(bitmap, BitmapPyramid::Box); });
+        double lanczos = measure([&]() { pyramid.build(bitmap, BitmapPyramid::Lanczos); });
+        printf("  %-6s box %8.2f ms, Lanczos %8.2f ms, %u levels\n", name, box * 1000, lanczos * 1000, (unsigned)pyramid.getLevelCount());
+    });
+}
+
+
+//measures drawing the bitmap at 1/8 scale, directly and through the pyramid
+void benchDraw(Bitmap &bitmap) {
+    const int size = imageSize / 8;
+    Bitmap target(size * 4, size * 4);
+    BitmapPyramid pyramid(bitmap, BitmapPyramid::Box);
+    target.setTarget();
+    double direct = measure([&]() {
+        for(int i = 0; i < 16; ++i) {
+            bitmap.drawScaled(0, 0, imageSize, imageSize, (i % 4) * size, (i / 4) * size, size, size);
+        }
+    });
+    double levels = measure([&]() {
+        for(int i = 0; i < 16; ++i) {
+            pyramid.drawScaled((i % 4) * size, (i / 4) * size, size, size);
+        }
+    });
+    printf("16 draws at 1/8 scale to a %ix%i memory bitmap\n", size * 4, size * 4);
+    printf("  Bitmap::drawScaled        %8.2f ms\n", direct * 1000);
+    printf("  BitmapPyramid::drawScaled %8.2f ms, level %u\n", levels * 1000, (unsigned)pyramid.selectLevel(imageSize, imageSize, size, size));
+}
+
+
+//main
+int main() {
+    al_init();
+    srand(1);
+
+    //everything lives in memory, so no display is needed
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+    Bitmap bitmap(imageSize, imageSize);
+    {
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+        PixelView<PixelFormat::ABGR_8888_LE> view(lock);
+        view.forEachPixel([](uint32_t &p) { p = ((uint32_t)rand() << 16) ^ (uint32_t)rand(); });
+    }
+
+    benchKernels();
+    benchBuild(bitmap);
+    benchDraw(bitmap);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "alx.hpp"
+#include <allegro5/allegro_image.h>
+using namespace alx;
+
+
+//number of loads averaged per measurement
+static const int passCount = 5;
+
+
+//names of the generated image contents
+static const char *contentNames[] = {"flat", "noise"};
+
+
+//runs a function a few times and returns the average time, in milliseconds
+template <class F> double measure(F f) {
+    f();
+    double start = al_get_time();
+    for(int i = 0; i < passCount; ++i) {
+        f();
+    }
+    return (al_get_time() - start) * 1000 / passCount;
+}
+
+
+//returns the size of a file, in kilobytes
+double fileSize(const char *filename) {
+    return FileEntry(filename).getSize() / 1024.0;
+}
+
+
+//reads a whole file into memory
+std::vector<uint8_t> readFile(const char *filename) {
+    File file(filename, "rb");
+    std::vector<uint8_t> data((size_t)file.getSize());
+    file.read(data.data(), data.size());
+    return data;
+}
+
+
+//creates a test image: sprite-like flat areas with soft edges, or incompressible noise
+Bitmap makeImage(int size, int content) {
+    Bitmap bitmap(size, size);
+    Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+    PixelView<PixelFormat::ABGR_8888_LE> view(lock);
+    view.forEachRow([&](uint32_t *row, int width, int y) {
+        for(int x = 0; x < width; ++x) {
+            if (content == 0) {
+                int cell = ((x / 64) ^ (y / 64)) & 3;
+                uint8_t a = (x % 64) < 2 || (y % 64) < 2 ? 128 : 255;
+                row[x] = PixelFormat::ABGR_8888_LE::pack(cell * 60, 255 - cell * 40, (uint8_t)(y * 255 / width), a);
+            }
+            else {
+                row[x] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+            }
+        }
+    });
+    return bitmap;
+}
+
+
+//compares loading one image from PNG and from raw bitmaps
+void run(int size, int content) {
+    std::string base = "bench_rawbitmap_" + std::to_string(size) + "_" + contentNames[content];
+    std::string png = base + ".png", raw = base + ".alxb", lz4 = base + "_lz4.alxb";
+    {
+        Bitmap bitmap = makeImage(size, content);
+        bitmap.save(png.c_str());
+        RawBitmap::save(raw.c_str(), bitmap, RawBitmap::None);
+        RawBitmap::save(lz4.c_str(), bitmap, RawBitmap::LZ4);
+    }
+
+    double pngTime = measure([&]() { Bitmap bitmap(png.c_str()); });
+    double rawTime = measure([&]() { RawBitmap::load(raw.c_str()); });
+    double lz4Time = measure([&]() { RawBitmap::load(lz4.c_str()); });
+
+    //loading from memory separates decoding from file reading
+    std::vector<uint8_t> rawData = readFile(raw.c_str()), lz4Data = readFile(lz4.c_str());
+    double rawMemTime = measure([&]() { RawBitmap::load(rawData.data(), rawData.size()); });
+    double lz4MemTime = measure([&]() { RawBitmap::load(lz4Data.data(), lz4Data.size()); });
+
+    printf("%4ix%-4i %-5s  png %8.2f ms %7.0f KB | raw %8.2f ms (mem %8.2f) %7.0f KB | lz4 %8.2f ms (mem %8.2f) %7.0f KB\n",
+        size, size, contentNames[content],
+        pngTime, fileSize(png.c_str()),
+        rawTime, rawMemTime, fileSize(raw.c_str()),
+        lz4Time, lz4MemTime, fileSize(lz4.c_str()));
+
+    FileEntry(png.c_str()).remove();
+    FileEntry(raw.c_str()).remove();
+    FileEntry(lz4.c_str()).remove();
+}
+
+
+//compares loading all images of a directory from their original files and from converted raw bitmaps
+void runDirectory(const char *dir) {
+    const char *cache = "bench_rawbitmap_cache";
+    al_make_directory(cache);
+    size_t count = RawBitmap::convertDirectory(dir, cache, RawBitmap::LZ4);
+
+    auto loadAll = [](const char *path) {
+        FileEntry entries(path);
+        for(FileEntry entry : entries) {
+            if (entry.isFile()) Bitmap bitmap(entry.getPath().cstr());
+        }
+    };
+    double original = measure([&]() { loadAll(dir); });
+    double converted = measure([&]() { loadAll(cache); });
+    printf("%s: %u images, original codecs %8.2f ms, LZ4 raw bitmaps %8.2f ms\n", dir, (unsigned)count, original, converted);
+
+    FileEntry entries(cache);
+    for(FileEntry entry : entries) {
+        entry.remove();
+    }
+    entries.remove();
+}
+
+
+//main; an optional argument names a directory of images to convert and compare, e.g. data
+int main(int argc, char **argv) {
+    al_init();
+    al_init_image_addon();
+    RawBitmap::registerFormat();
+
+    //decoded images stay in memory, so that only loading is measured and no display is needed
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    srand(1);
+
+    printf("load times, average of %i loads; mem is loading a file already read into memory\n", passCount);
+    for(int size : {256, 1024, 2048}) {
+        for(int content = 0; content < 2; ++content) {
+            run(size, content);
+        }
+    }
+
+    if (argc > 1) runDirectory(argv[1]);
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "alx.hpp"
+using namespace alx;
+
+
+//scene parameters
+static const int spriteCount = 50000;
+static const int frameCount = 10;
+static const int targetWidth = 1920;
+static const int targetHeight = 1080;
+
+
+//a sprite of the scene
+struct Sprite {
+    Bitmap *bitmap;
+    float x, y;
+    float angle;
+    ALLEGRO_COLOR color;
+    bool tinted;
+    bool rotated;
+};
+
+
+//returns a random float in [0, n)
+float rnd(float n) {
+    return n * rand() / ((float)RAND_MAX + 1);
+}
+
+
+//draws the scene with one Bitmap call per sprite
+void drawPerSprite(std::vector<Sprite> &sprites) {
+    for(Sprite &s : sprites) {
+        if (s.rotated) {
+            s.bitmap->drawScaledRotated(s.color, s.bitmap->getWidth() / 2.0f, s.bitmap->getHeight() / 2.0f, s.x, s.y, 1, 1, s.angle);
+        }
+        else if (s.tinted) {
+            s.bitmap->drawTinted(s.color, s.x, s.y);
+        }
+        else {
+            s.bitmap->draw(s.x, s.y);
+        }
+    }
+}
+
+
+//draws the scene through a sprite batch
+void drawBatched(SpriteBatch &batch, const std::vector<Sprite> &sprites) {
+    for(const Sprite &s : sprites) {
+        if (s.rotated) {
+            batch.drawScaledRotated(*s.bitmap, s.color, s.bitmap->getWidth() / 2.0f, s.bitmap->getHeight() / 2.0f, s.x, s.y, 1, 1, s.angle);
+        }
+        else if (s.tinted) {
+            batch.drawTinted(*s.bitmap, s.color, s.x, s.y);
+        }
+        else {
+            batch.draw(*s.bitmap, s.x, s.y);
+        }
+    }
+    batch.flush();
+}
+
+
+//runs the given frame function and returns the average time per frame, in milliseconds
+template <class F> double measure(F frame) {
+    frame();
+    double start = al_get_time();
+    for(int i = 0; i < frameCount; ++i) {
+        frame();
+    }
+    return (al_get_time() - start) * 1000 / frameCount;
+}
+
+
+//main
+int main() {
+    al_init();
+    al_init_primitives_addon();
+
+    //everything lives in memory, so no display is needed
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    Bitmap target(targetWidth, targetHeight);
+
+    //a sprite sheet of 16 cells, plus a few standalone bitmaps
+    Bitmap sheet(256, 256);
+    sheet.setTarget();
+    al_clear_to_color(Color(255, 128, 64));
+    std::vector<Bitmap> bitmaps;
+    for(int j = 0; j < 4; ++j) {
+        for(int i = 0; i < 4; ++i) {
+            bitmaps.push_back(Bitmap(sheet, i * 64, j * 64, 64, 64));
+        }
+    }
+    for(int i = 0; i < 4; ++i) {
+        Bitmap bitmap(32, 32);
+        bitmap.setTarget();
+        al_clear_to_color(Color(64 * i, 255, 128));
+        bitmaps.push_back(bitmap);
+    }
+
+    //the scene: a quarter of the sprites are tinted and another quarter rotated
+    srand(1);
+    std::vector<Sprite> sprites(spriteCount);
+    for(Sprite &s : sprites) {
+        s.bitmap = &bitmaps[rand() % bitmaps.size()];
+        s.x = rnd(targetWidth);
+        s.y = rnd(targetHeight);
+        s.angle = rnd(6.283f);
+        s.color = Color(rnd(1), rnd(1), rnd(1), 1.0f);
+        int kind = rand() % 4;
+        s.tinted = kind == 1;
+        s.rotated = kind == 2;
+    }
+
+    target.setTarget();
+    SpriteBatch sortedBatch(true, spriteCount);
+    SpriteBatch orderedBatch(false, spriteCount);
+
+    double perSprite = measure([&]() { drawPerSprite(sprites); });
+    double held = measure([&]() { Bitmap::HoldDrawing hold; drawPerSprite(sprites); });
+    double sorted = measure([&]() { drawBatched(sortedBatch, sprites); });
+    double ordered = measure([&]() { drawBatched(orderedBatch, sprites); });
+
+    printf("%i sprites from %u bitmaps on a %ix%i memory bitmap, %i frames\n", spriteCount, (unsigned)bitmaps.size(), targetWidth, targetHeight, frameCount);
+    printf("Bitmap::draw per sprite:       %8.2f ms/frame\n", perSprite);
+    printf("Bitmap::draw with HoldDrawing: %8.2f ms/frame\n", held);
+    printf("SpriteBatch, sorted:           %8.2f ms/frame, %u draw calls\n", sorted, (unsigned)sortedBatch.getDrawCallCount());
+    printf("SpriteBatch, ordered:          %8.2f ms/frame, %u draw calls\n", ordered, (unsigned)orderedBatch.getDrawCallCount());
+
+    return 0;
+}
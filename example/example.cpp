@@ -46,6 +46,12 @@ bool collision(const Sprite &a, const Sprite &b) {
 }
 
 
+//check pixel-perfect collision between two sprites
+bool collision(const Sprite &a, const CollisionMask &maskA, const Sprite &b, const CollisionMask &maskB) {
+    return maskA.overlaps(a.position, maskB, b.position);
+}
+
+
 //deflects the ball off a block
 void deflectBall(Sprite &ball, const Sprite &block) {
     Rect<int> ballRect = ball.getRect();
@@ -86,13 +92,20 @@ int main() {
 
     //bitmaps
     Bitmap paddleBmp("data/paddle.bmp");
-    paddleBmp.convertMaskToAlpha(Color(0xFFFFFFFF));
+    PixelOps::convertMaskToAlpha(paddleBmp, Color(0xFFFFFFFF));
     Bitmap ballBmp("data/ball.bmp");
-    ballBmp.convertMaskToAlpha(Color(0xFFFFFFFF));
-    std::vector<Bitmap> stones;
+    PixelOps::convertMaskToAlpha(ballBmp, Color(0xFFFFFFFF));
+    CollisionMask paddleMask(paddleBmp);
+    CollisionMask ballMask(ballBmp);
+    TextureAtlas atlas;
     for(int i = 1; i <= 23; ++i) {
-        stones.push_back(Bitmap(String("data/stone") + i + ".jpg"));
+        atlas.add(String("data/stone") + i + ".jpg");
     } 
+    atlas.build();
+    std::vector<Bitmap> stones;
+    for(size_t i = 0; i < atlas.getEntryCount(); ++i) {
+        stones.push_back(atlas.getBitmap(i));
+    }
 
     //blocks
     std::vector<SpritePtr> blocks;
@@ -155,7 +168,7 @@ int main() {
         }
 
         //check if the ball collides with the paddle
-        if (collision(ball, paddle)) {
+        if (collision(ball, ballMask, paddle, paddleMask)) {
             textLog << "collision between ball and paddle\n";
             if (ball.getRect().getCenterX() < paddle.getRect().getCenterX()) {
                 ball.velocity.setX(-1);
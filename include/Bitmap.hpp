@@ -126,6 +126,14 @@ public:
         return Size<int>(al_get_bitmap_width(get()), al_get_bitmap_height(get()));
     }
 
+    /**
+        Estimates the memory used by the bitmap's pixels, from its size and pixel format.
+        @return the estimated size in bytes.
+     */
+    size_t getByteSize() const {
+        return (size_t)al_get_bitmap_width(get()) * al_get_bitmap_height(get()) * al_get_pixel_size(getFormat());
+    }
+
     /**
         Returns a pixel.
         @param x x coordinate.
@@ -212,7 +220,7 @@ public:
             @param format pixel format.
             @param flags flags.
          */
-        Lock(Bitmap &bitmap, int format, int flags) : m_bitmap(bitmap) {
+        Lock(Bitmap &bitmap, int format, int flags) : m_bitmap(bitmap), m_width(bitmap.getWidth()), m_height(bitmap.getHeight()) {
             m_region = m_bitmap.lock(format, flags);
         }
 
@@ -226,7 +234,7 @@ public:
             @param format pixel format.
             @param flags flags.
          */
-        Lock(Bitmap &bitmap, int x, int y, int width, int height, int format, int flags) : m_bitmap(bitmap) {
+        Lock(Bitmap &bitmap, int x, int y, int width, int height, int format, int flags) : m_bitmap(bitmap), m_width(width), m_height(height) {
             m_region = m_bitmap.lock(x, y, width, height, format, flags);
         }
 
@@ -245,9 +253,27 @@ public:
             return m_region;
         }
 
+        /**
+            Returns the width of the locked area.
+            @return the width of the locked area.
+         */
+        int getWidth() const {
+            return m_width;
+        }
+
+        /**
+            Returns the height of the locked area.
+            @return the height of the locked area.
+         */
+        int getHeight() const {
+            return m_height;
+        }
+
     private:
         Bitmap &m_bitmap;
         ALLEGRO_LOCKED_REGION *m_region;
+        int m_width;
+        int m_height;
     };
 
     /**
@@ -452,6 +478,26 @@ public:
         return (bool)(*this);
     }
 
+    /**
+        loads a bitmap from memory, for example from a memory-mapped pack; the buffer is not copied.
+        Once RawBitmap::registerFormat() is called, raw bitmaps are decoded straight from the buffer into the locked bitmap;
+        other formats are decoded by Allegro through a memfile over the buffer.
+        @param data data.
+        @param size size of the data, in bytes.
+        @param ext filename extension of the data's format; if null, Allegro identifies the format from the data.
+        @return true on success.
+     */
+    bool loadFromMemory(const void *data, size_t size, const char *ext = nullptr) {
+        ALLEGRO_BITMAP *raw = _rawLoader() ? _rawLoader()(data, size) : nullptr;
+        if (raw) {
+            reset(raw, al_destroy_bitmap);
+            return true;
+        }
+        File file((void *)data, size, "r");
+        reset(al_load_bitmap_f(file.get(), ext), al_destroy_bitmap);
+        return (bool)(*this);
+    }
+
     /**
         Saves a bitmap.
         @param filename filename.
@@ -478,6 +524,18 @@ public:
      */
     Bitmap(ALLEGRO_BITMAP *object, bool managed = true) : Shared(object, managed, al_destroy_bitmap) {
     }
+
+private:
+    friend class RawBitmap;
+
+    //loads a raw bitmap from memory; returns null if the data is not a raw bitmap
+    typedef ALLEGRO_BITMAP *(*_RawLoader)(const void *data, size_t size);
+
+    //internal raw bitmap loader, set by RawBitmap::registerFormat()
+    static _RawLoader &_rawLoader() {
+        static _RawLoader loader = nullptr;
+        return loader;
+    }
 };
 
 
@@ -0,0 +1,207 @@
+#ifndef ALX_BITMAP_CACHE_HPP
+#define ALX_BITMAP_CACHE_HPP
+
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "Bitmap.hpp"
+
+
+namespace alx {
+
+
+/**
+    Cache of bitmaps loaded from files, keyed by filename.
+    The estimated size of the cached bitmaps is kept under a byte budget by evicting the least recently used ones.
+    Evicting a bitmap only drops the cache's reference; bitmaps still in use elsewhere stay alive.
+ */
+class BitmapCache {
+public:
+    /**
+        Constructor.
+        @param budget maximum estimated size of the cached bitmaps, in bytes.
+     */
+    BitmapCache(size_t budget = 64 * 1024 * 1024) :
+        m_budget(budget),
+        m_usage(0),
+        m_hitCount(0),
+        m_missCount(0),
+        m_evictionCount(0)
+    {
+    }
+
+    /**
+        Returns the bitmap of the given file, loading it if it is not in the cache.
+        Bitmaps that fail to load are not cached.
+        @param filename filename.
+        @return the bitmap; null if loading failed.
+     */
+    Bitmap get(const char *filename) {
+        Map::iterator it = m_map.find(filename);
+        if (it != m_map.end()) {
+            ++m_hitCount;
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return it->second->bitmap;
+        }
+
+        ++m_missCount;
+        Bitmap bitmap(filename);
+        if (!bitmap) return bitmap;
+        Entry entry = {filename, bitmap, getByteCost(bitmap)};
+        m_entries.push_front(entry);
+        m_map[entry.filename] = m_entries.begin();
+        m_usage += entry.cost;
+        _evict();
+        return bitmap;
+    }
+
+    /**
+        Checks if the given file is in the cache.
+        It does not affect the usage order or the counters.
+        @param filename filename.
+        @return true if cached.
+     */
+    bool contains(const char *filename) const {
+        return m_map.find(filename) != m_map.end();
+    }
+
+    /**
+        Removes the given file from the cache.
+        @param filename filename.
+        @return true if it was cached.
+     */
+    bool remove(const char *filename) {
+        Map::iterator it = m_map.find(filename);
+        if (it == m_map.end()) return false;
+        m_usage -= it->second->cost;
+        m_entries.erase(it->second);
+        m_map.erase(it);
+        return true;
+    }
+
+    /**
+        Removes all bitmaps from the cache.
+        The counters are not reset.
+     */
+    void clear() {
+        m_entries.clear();
+        m_map.clear();
+        m_usage = 0;
+    }
+
+    /**
+        Returns the budget.
+        @return the budget in bytes.
+     */
+    size_t getBudget() const {
+        return m_budget;
+    }
+
+    /**
+        Sets the budget; bitmaps are evicted as needed.
+        @param budget the budget in bytes.
+     */
+    void setBudget(size_t budget) {
+        m_budget = budget;
+        _evict();
+    }
+
+    /**
+        Returns the estimated size of the cached bitmaps.
+        @return the estimated size of the cached bitmaps, in bytes.
+     */
+    size_t getUsage() const {
+        return m_usage;
+    }
+
+    /**
+        Returns the number of cached bitmaps.
+        @return the number of cached bitmaps.
+     */
+    size_t getCount() const {
+        return m_entries.size();
+    }
+
+    /**
+        Returns the number of requests served from the cache.
+        @return the number of hits.
+     */
+    size_t getHitCount() const {
+        return m_hitCount;
+    }
+
+    /**
+        Returns the number of requests that had to load the file.
+        @return the number of misses.
+     */
+    size_t getMissCount() const {
+        return m_missCount;
+    }
+
+    /**
+        Returns the number of bitmaps evicted to stay within the budget.
+        @return the number of evictions.
+     */
+    size_t getEvictionCount() const {
+        return m_evictionCount;
+    }
+
+    /**
+        Resets the hit, miss and eviction counters.
+     */
+    void resetCounters() {
+        m_hitCount = 0;
+        m_missCount = 0;
+        m_evictionCount = 0;
+    }
+
+    /**
+        Estimates the memory used by a bitmap from its size and pixel format.
+        @param bitmap bitmap.
+        @return the estimated size in bytes.
+     */
+    static size_t getByteCost(const Bitmap &bitmap) {
+        return bitmap.getByteSize();
+    }
+
+private:
+    //cache entry
+    struct Entry {
+        std::string filename;
+        Bitmap bitmap;
+        size_t cost;
+    };
+
+    //entries, most recently used first
+    typedef std::list<Entry> List;
+    typedef std::unordered_map<std::string, List::iterator> Map;
+    List m_entries;
+    Map m_map;
+
+    //budget and usage
+    size_t m_budget;
+    size_t m_usage;
+
+    //counters
+    size_t m_hitCount;
+    size_t m_missCount;
+    size_t m_evictionCount;
+
+    //evicts the least recently used entries until the usage is within the budget; the most recent entry is always kept
+    void _evict() {
+        while (m_usage > m_budget && m_entries.size() > 1) {
+            Entry &entry = m_entries.back();
+            m_usage -= entry.cost;
+            m_map.erase(entry.filename);
+            m_entries.pop_back();
+            ++m_evictionCount;
+        }
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_BITMAP_CACHE_HPP
@@ -0,0 +1,287 @@
+#ifndef ALX_BITMAP_LOADER_HPP
+#define ALX_BITMAP_LOADER_HPP
+
+
+#include <deque>
+#include <vector>
+#include <string>
+#include "Bitmap.hpp"
+#include "State.hpp"
+#include "Thread.hpp"
+#include "Condition.hpp"
+#include "Event.hpp"
+#include "UserEvent.hpp"
+#include "UserEventSource.hpp"
+
+
+namespace alx {
+
+
+/**
+    Loads bitmaps in the background.
+    Files are decoded into memory bitmaps by a pool of worker threads.
+    The display thread then calls finalize() once per frame, which converts a bounded number of decoded
+    bitmaps to the bitmap flags that were current when load() was called, and emits a LoadedEvent for each.
+ */
+class BitmapLoader : public UserEventSource {
+    struct Request;
+
+public:
+    /**
+        Default type of the events emitted by the loader.
+     */
+    static const int DefaultEventType = ALLEGRO_GET_EVENT_TYPE('A', 'L', 'X', 'L');
+
+    /**
+        Future-like handle to a bitmap being loaded.
+        The handle's state changes only inside finalize(), so it is safe to query from the display thread.
+     */
+    class Handle {
+    public:
+        /**
+            Null constructor.
+         */
+        Handle() {
+        }
+
+        /**
+            Checks if loading has completed, successfully or not.
+            @return true if completed.
+         */
+        bool isDone() const {
+            return m_request && m_request->state != Request::Pending;
+        }
+
+        /**
+            Checks if the bitmap was loaded successfully.
+            @return true if the bitmap is available.
+         */
+        bool isReady() const {
+            return m_request && m_request->state == Request::Ready;
+        }
+
+        /**
+            Checks if the bitmap failed to load.
+            @return true on failure.
+         */
+        bool isFailed() const {
+            return m_request && m_request->state == Request::Failed;
+        }
+
+        /**
+            Returns the loaded bitmap.
+            @return the loaded bitmap; null if it is not ready.
+         */
+        Bitmap getBitmap() const {
+            return isReady() ? m_request->bitmap : Bitmap();
+        }
+
+        /**
+            Returns the filename.
+            @return the filename; empty for a null handle.
+         */
+        const std::string &getFilename() const {
+            static const std::string empty;
+            return m_request ? m_request->filename : empty;
+        }
+
+        /**
+            Checks if the handle is valid.
+            @return true if valid.
+         */
+        operator bool () const {
+            return (bool)m_request;
+        }
+
+    private:
+        std::shared_ptr<Request> m_request;
+
+        Handle(const std::shared_ptr<Request> &request) : m_request(request) {
+        }
+
+        friend class BitmapLoader;
+    };
+
+    /**
+        Event emitted when a bitmap has been finalized, successfully or not.
+     */
+    class LoadedEvent : public UserEvent {
+    public:
+        /**
+            constructor.
+            @param type event type.
+            @param handle handle of the loaded bitmap.
+         */
+        LoadedEvent(int type, const Handle &handle) : UserEvent(type), m_handle(handle) {
+        }
+
+        /**
+            Returns the handle of the loaded bitmap.
+            @return the handle of the loaded bitmap.
+         */
+        const Handle &getHandle() const {
+            return m_handle;
+        }
+
+    private:
+        Handle m_handle;
+    };
+
+    /**
+        Constructor.
+        Starts the worker threads.
+        @param threadCount number of worker threads.
+        @param eventType type of the emitted events.
+     */
+    BitmapLoader(int threadCount = 2, int eventType = DefaultEventType) :
+        m_eventType(eventType),
+        m_stop(false),
+        m_pendingCount(0)
+    {
+        for(int i = 0; i < threadCount; ++i) {
+            m_threads.push_back(Thread([this]() { return _work(); }));
+            m_threads.back().start();
+        }
+    }
+
+    /**
+        Destructor.
+        Stops the worker threads; requests that have not been decoded yet are dropped.
+     */
+    ~BitmapLoader() {
+        m_mutex.lock();
+        m_stop = true;
+        m_condition.wakeAll();
+        m_mutex.unlock();
+        for(Thread &thread : m_threads) {
+            thread.wait();
+        }
+    }
+
+    /**
+        Queues a bitmap for loading.
+        The new bitmap flags of the calling thread are applied when the bitmap is finalized.
+        @param filename filename.
+        @return handle to the bitmap.
+     */
+    Handle load(const char *filename) {
+        std::shared_ptr<Request> request(new Request);
+        request->filename = filename;
+        request->flags = al_get_new_bitmap_flags();
+        request->format = al_get_new_bitmap_format();
+        request->state = Request::Pending;
+        Lock<Mutex> lock(m_mutex);
+        m_queue.push_back(request);
+        ++m_pendingCount;
+        m_condition.wakeOne();
+        return Handle(request);
+    }
+
+    /**
+        Finalizes decoded bitmaps; must be called from the display thread, usually once per frame.
+        @param maxCount maximum number of bitmaps to finalize.
+        @param maxSeconds time budget; finalization stops after this many seconds have passed; 0 for no limit.
+        @return number of bitmaps finalized.
+     */
+    size_t finalize(size_t maxCount = 8, double maxSeconds = 0) {
+        double start = maxSeconds > 0 ? al_get_time() : 0;
+        size_t count = 0;
+        State state;
+        state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+        while (count < maxCount) {
+            std::shared_ptr<Request> request;
+            {
+                Lock<Mutex> lock(m_mutex);
+                if (m_decoded.empty()) break;
+                request = m_decoded.front();
+                m_decoded.pop_front();
+                --m_pendingCount;
+            }
+
+            if (request->bitmap) {
+                if (!(request->flags & ALLEGRO_MEMORY_BITMAP)) {
+                    al_set_new_bitmap_flags(request->flags);
+                    al_set_new_bitmap_format(request->format);
+                    al_convert_bitmap(request->bitmap.get());
+                }
+                request->state = Request::Ready;
+            }
+            else {
+                request->state = Request::Failed;
+            }
+            emitUserEvent(new LoadedEvent(m_eventType, Handle(request)));
+            ++count;
+
+            if (maxSeconds > 0 && al_get_time() - start >= maxSeconds) break;
+        }
+        state.restore();
+        return count;
+    }
+
+    /**
+        Returns the number of requests that have not been finalized yet.
+        @return the number of pending requests.
+     */
+    size_t getPendingCount() const {
+        Lock<Mutex> lock(m_mutex);
+        return m_pendingCount;
+    }
+
+private:
+    //a load request
+    struct Request {
+        enum {Pending, Ready, Failed};
+        std::string filename;
+        int flags;
+        int format;
+        int state;
+        Bitmap bitmap;
+    };
+
+    //event type
+    int m_eventType;
+
+    //workers
+    std::vector<Thread> m_threads;
+
+    //synchronization
+    mutable Mutex m_mutex;
+    Condition m_condition;
+    bool m_stop;
+
+    //requests waiting for decoding, and decoded requests waiting for finalization
+    std::deque<std::shared_ptr<Request>> m_queue;
+    std::deque<std::shared_ptr<Request>> m_decoded;
+    size_t m_pendingCount;
+
+    //worker thread loop
+    void *_work() {
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+        for(;;) {
+            std::shared_ptr<Request> request;
+            {
+                Lock<Mutex> lock(m_mutex);
+                while (m_queue.empty() && !m_stop) {
+                    m_condition.wait(m_mutex);
+                }
+                if (m_stop) break;
+                request = m_queue.front();
+                m_queue.pop_front();
+            }
+
+            al_set_new_bitmap_format(request->format);
+            Bitmap bitmap(request->filename.c_str());
+
+            Lock<Mutex> lock(m_mutex);
+            request->bitmap = bitmap;
+            m_decoded.push_back(request);
+        }
+        return nullptr;
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_BITMAP_LOADER_HPP
@@ -0,0 +1,414 @@
+#ifndef ALX_BITMAP_PYRAMID_HPP
+#define ALX_BITMAP_PYRAMID_HPP
+
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "Cpu.hpp"
+#include "Bitmap.hpp"
+#include "State.hpp"
+
+
+namespace alx {
+
+
+/**
+    A downscale pyramid of a bitmap: level 0 is the bitmap itself, and each next level is half the size of the previous one.
+    The levels are computed on locked memory bitmaps, with a box or a Lanczos-3 filter, using SIMD kernels when available;
+    they are then converted to the flags and format of the source bitmap.
+    Drawing through the pyramid picks the level nearest to the destination size, which avoids the aliasing
+    and the wasted fill rate of drawing a large bitmap at a small scale.
+ */
+class BitmapPyramid {
+public:
+    /**
+        Downscale filters: 2x2 pixel average, or the sharper but slower Lanczos-3.
+     */
+    enum Filter {
+        Box,
+        Lanczos
+    };
+
+    /**
+        The empty constructor.
+     */
+    BitmapPyramid() {
+    }
+
+    /**
+        Builds the pyramid of a bitmap.
+        @param bitmap source bitmap.
+        @param filter downscale filter.
+        @param minSize minimum width and height of the smallest level.
+     */
+    BitmapPyramid(const Bitmap &bitmap, Filter filter = Box, int minSize = 1) {
+        build(bitmap, filter, minSize);
+    }
+
+    /**
+        Builds the pyramid of a bitmap, replacing the current levels.
+        Levels are added while both the width and the height of the next level are at least minSize.
+        @param bitmap source bitmap.
+        @param filter downscale filter.
+        @param minSize minimum width and height of the smallest level.
+        @return true on success; on failure, the pyramid contains only the levels built so far.
+     */
+    bool build(const Bitmap &bitmap, Filter filter = Box, int minSize = 1) {
+        m_levels.clear();
+        if (!bitmap) return false;
+        m_levels.push_back(bitmap);
+        minSize = std::max(minSize, 1);
+
+        State state;
+        state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+        al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+
+        bool ok = true;
+        for(;;) {
+            Bitmap &src = m_levels.back();
+            int width = src.getWidth() / 2, height = src.getHeight() / 2;
+            if (width < minSize || height < minSize) break;
+            Bitmap dst(width, height);
+            if (!dst) {
+                ok = false;
+                break;
+            }
+            {
+                Bitmap::Lock srcLock(src, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+                Bitmap::Lock dstLock(dst, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+                ok = downscale(dstLock, srcLock, filter);
+            }
+            if (!ok) break;
+            m_levels.push_back(dst);
+        }
+
+        //convert the levels to the source's kind of bitmap
+        if (bitmap.getFlags() != ALLEGRO_MEMORY_BITMAP || bitmap.getFormat() != ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE) {
+            al_set_new_bitmap_flags(bitmap.getFlags());
+            al_set_new_bitmap_format(bitmap.getFormat());
+            for(size_t i = 1; i < m_levels.size(); ++i) {
+                al_convert_bitmap(m_levels[i].get());
+            }
+        }
+
+        state.restore();
+        return ok;
+    }
+
+    /**
+        Releases all levels.
+     */
+    void clear() {
+        m_levels.clear();
+    }
+
+    /**
+        Returns the number of levels.
+        @return the number of levels.
+     */
+    size_t getLevelCount() const {
+        return m_levels.size();
+    }
+
+    /**
+        Returns a level.
+        @param index level index; 0 is the source bitmap.
+        @return the level.
+     */
+    const Bitmap &getLevel(size_t index) const {
+        return m_levels[index];
+    }
+
+    /**
+        Returns the index of the level nearest to the given scaling;
+        the levels are spaced by powers of two, and the nearest one is picked in that scale.
+        @param sw source width, at level 0.
+        @param sh source height, at level 0.
+        @param dw destination width.
+        @param dh destination height.
+        @return the level index, or 0 if there are no levels.
+     */
+    size_t selectLevel(float sw, float sh, float dw, float dh) const {
+        if (m_levels.size() < 2 || dw == 0 || dh == 0) return 0;
+        float ratio = std::min(std::fabs(sw / dw), std::fabs(sh / dh));
+        if (ratio <= 1) return 0;
+        size_t level = (size_t)std::floor(std::log2(ratio) + 0.5f);
+        return std::min(level, m_levels.size() - 1);
+    }
+
+    /**
+        Draws a scaled part of the bitmap, using the level nearest to the destination size.
+        @param sx source x, at level 0.
+        @param sy source y, at level 0.
+        @param sw source width, at level 0.
+        @param sh source height, at level 0.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawScaled(float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags = 0) {
+        if (m_levels.empty()) return;
+        float fx, fy;
+        Bitmap &level = _level(sw, sh, dw, dh, fx, fy);
+        level.drawScaled(sx * fx, sy * fy, sw * fx, sh * fy, dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Draws the bitmap scaled, using the level nearest to the destination size.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawScaled(float dx, float dy, float dw, float dh, int flags = 0) {
+        if (m_levels.empty()) return;
+        drawScaled(0, 0, (float)m_levels[0].getWidth(), (float)m_levels[0].getHeight(), dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Draws a tinted scaled part of the bitmap, using the level nearest to the destination size.
+        @param color color.
+        @param sx source x, at level 0.
+        @param sy source y, at level 0.
+        @param sw source width, at level 0.
+        @param sh source height, at level 0.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawTintedScaled(const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags = 0) {
+        if (m_levels.empty()) return;
+        float fx, fy;
+        Bitmap &level = _level(sw, sh, dw, dh, fx, fy);
+        level.drawTintedScaled(color, sx * fx, sy * fy, sw * fx, sh * fy, dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Downscales a locked region to half its size.
+        Both regions must be locked in the same 32-bit format; the destination size must be half the source size,
+        rounded down, or 1 if the source size is 1.
+        @param dst destination lock.
+        @param src source lock.
+        @param filter filter.
+        @return true on success.
+     */
+    static bool downscale(const Bitmap::Lock &dst, const Bitmap::Lock &src, Filter filter) {
+        const ALLEGRO_LOCKED_REGION *dr = dst.getLockedRegion(), *sr = src.getLockedRegion();
+        if (!dr || !sr || dr->pixel_size != 4 || sr->pixel_size != 4 || dr->format != sr->format) return false;
+        int dw = dst.getWidth(), dh = dst.getHeight(), sw = src.getWidth(), sh = src.getHeight();
+        if (dw != std::max(sw / 2, 1) || dh != std::max(sh / 2, 1)) return false;
+        if (filter == Lanczos) {
+            _downscaleLanczos(dr, dw, dh, sr, sw, sh);
+            return true;
+        }
+        for(int y = 0; y < dh; ++y) {
+            const uint32_t *row0 = _row(sr, std::min(y * 2, sh - 1));
+            const uint32_t *row1 = _row(sr, std::min(y * 2 + 1, sh - 1));
+            uint32_t *out = _row(dr, y);
+            if (sw >= 2) {
+                boxRow(out, row0, row1, dw);
+            }
+            else {
+                out[0] = _average(row0[0], row0[0], row1[0], row1[0]);
+            }
+        }
+        return true;
+    }
+
+    /**
+        Averages 2x2 blocks of pixels of two rows into one row.
+        @param dst destination row; n pixels.
+        @param row0 first source row; 2n pixels.
+        @param row1 second source row; 2n pixels.
+        @param n number of destination pixels.
+     */
+    static void boxRow(uint32_t *dst, const uint32_t *row0, const uint32_t *row1, int n) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _boxAVX2(dst, row0, row1, n);
+        else if (Cpu::hasSSE2()) i = _boxSSE2(dst, row0, row1, n);
+#endif
+        for(; i < n; ++i) {
+            dst[i] = _average(row0[i * 2], row0[i * 2 + 1], row1[i * 2], row1[i * 2 + 1]);
+        }
+    }
+
+    /**
+        Combines twelve rows of float channels with the Lanczos weights and stores the result as bytes.
+        @param dst destination row; n pixels.
+        @param rows source rows; n pixels of four floats each.
+        @param w twelve weights.
+        @param n number of pixels.
+     */
+    static void lanczosColumn(uint8_t *dst, const float *const rows[12], const float *w, int n) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasSSE2()) i = _lanczosColumnSSE2(dst, rows, w, n);
+#endif
+        for(; i < n * 4; ++i) {
+            float acc = 0;
+            for(int k = 0; k < 12; ++k) {
+                acc += w[k] * rows[k][i];
+            }
+            dst[i] = (uint8_t)std::min(std::max((int)std::nearbyint(acc), 0), 255);
+        }
+    }
+
+private:
+    //levels
+    std::vector<Bitmap> m_levels;
+
+    //returns the level to draw and the factors from level 0 coordinates to it
+    Bitmap &_level(float sw, float sh, float dw, float dh, float &fx, float &fy) {
+        Bitmap &level = m_levels[selectLevel(sw, sh, dw, dh)];
+        fx = (float)level.getWidth() / m_levels[0].getWidth();
+        fy = (float)level.getHeight() / m_levels[0].getHeight();
+        return level;
+    }
+
+    //returns a row of a locked region
+    static uint32_t *_row(const ALLEGRO_LOCKED_REGION *region, int y) {
+        return (uint32_t *)((uint8_t *)region->data + (intptr_t)y * region->pitch);
+    }
+
+    //rounded average of four pixels, per byte
+    static uint32_t _average(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        uint32_t result = 0;
+        for(int shift = 0; shift < 32; shift += 8) {
+            uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+            result |= ((sum + 2) >> 2) << shift;
+        }
+        return result;
+    }
+
+    //Lanczos-3 weights for halving; tap k covers source pixel 2x + k - 5
+    static const float *_lanczosWeights() {
+        static const std::vector<float> weights = []() {
+            const float pi = 3.14159265358979f;
+            std::vector<float> w(12);
+            float sum = 0;
+            for(int k = 0; k < 12; ++k) {
+                float d = (k - 5.5f) / 2;
+                w[k] = std::sin(pi * d) * std::sin(pi * d / 3) / (pi * pi * d * d / 3);
+                sum += w[k];
+            }
+            for(float &v : w) {
+                v /= sum;
+            }
+            return w;
+        }();
+        return weights.data();
+    }
+
+    //separable Lanczos-3 halving: horizontal pass into a float buffer, then a vertical pass per destination row
+    static void _downscaleLanczos(const ALLEGRO_LOCKED_REGION *dr, int dw, int dh, const ALLEGRO_LOCKED_REGION *sr, int sw, int sh) {
+        const float *w = _lanczosWeights();
+        size_t stride = (size_t)dw * 4;
+        std::vector<float> temp(stride * sh);
+
+        for(int y = 0; y < sh; ++y) {
+            const uint8_t *src = (const uint8_t *)_row(sr, y);
+            float *out = &temp[stride * y];
+            for(int x = 0; x < dw; ++x) {
+                float acc[4] = {0, 0, 0, 0};
+                for(int k = 0; k < 12; ++k) {
+                    const uint8_t *p = src + std::min(std::max(x * 2 + k - 5, 0), sw - 1) * 4;
+                    acc[0] += w[k] * p[0];
+                    acc[1] += w[k] * p[1];
+                    acc[2] += w[k] * p[2];
+                    acc[3] += w[k] * p[3];
+                }
+                out[x * 4 + 0] = acc[0];
+                out[x * 4 + 1] = acc[1];
+                out[x * 4 + 2] = acc[2];
+                out[x * 4 + 3] = acc[3];
+            }
+        }
+
+        for(int y = 0; y < dh; ++y) {
+            const float *rows[12];
+            for(int k = 0; k < 12; ++k) {
+                rows[k] = &temp[stride * std::min(std::max(y * 2 + k - 5, 0), sh - 1)];
+            }
+            lanczosColumn((uint8_t *)_row(dr, y), rows, w, dw);
+        }
+    }
+
+private:
+#ifdef ALX_X86
+
+    //SSE2 kernels; they return the number of elements processed
+
+    ALX_TARGET_SSE2 static int _boxSSE2(uint32_t *dst, const uint32_t *row0, const uint32_t *row1, int n) {
+        const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i r[2];
+            for(int h = 0; h < 2; ++h) {
+                __m128i a = _mm_loadu_si128((const __m128i *)(row0 + i * 2 + h * 4));
+                __m128i b = _mm_loadu_si128((const __m128i *)(row1 + i * 2 + h * 4));
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                r[h] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+            }
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(r[0], r[1]));
+        }
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static int _lanczosColumnSSE2(uint8_t *dst, const float *const rows[12], const float *w, int n) {
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i c[4];
+            for(int p = 0; p < 4; ++p) {
+                __m128 acc = _mm_setzero_ps();
+                for(int k = 0; k < 12; ++k) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(rows[k] + (i + p) * 4)));
+                }
+                c[p] = _mm_cvtps_epi32(acc);
+            }
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), packed);
+        }
+        return i * 4;
+    }
+
+    //AVX2 kernels; they return the number of elements processed
+
+    ALX_TARGET_AVX2 static int _boxAVX2(uint32_t *dst, const uint32_t *row0, const uint32_t *row1, int n) {
+        const __m256i zero = _mm256_setzero_si256(), two = _mm256_set1_epi16(2);
+        int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256i r[2];
+            for(int h = 0; h < 2; ++h) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)(row0 + i * 2 + h * 8));
+                __m256i b = _mm256_loadu_si256((const __m256i *)(row1 + i * 2 + h * 8));
+                __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+                __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+                __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+                r[h] = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+            }
+            //packing works per 128-bit lane; restore the pixel order
+            __m256i packed = _mm256_packus_epi16(r[0], r[1]);
+            _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute4x64_epi64(packed, 0xd8));
+        }
+        return i;
+    }
+
+#endif //ALX_X86
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_BITMAP_PYRAMID_HPP
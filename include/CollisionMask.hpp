@@ -0,0 +1,285 @@
+#ifndef ALX_COLLISION_MASK_HPP
+#define ALX_COLLISION_MASK_HPP
+
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "Cpu.hpp"
+#include "Bitmap.hpp"
+#include "Point.hpp"
+#include "Rect.hpp"
+#include "Size.hpp"
+
+
+namespace alx {
+
+
+/**
+    A pixel-perfect collision mask, generated once from the alpha channel of a bitmap.
+    Solid pixels are packed 64 per word, bit (x % 64) of word (x / 64) of each row.
+    The mask keeps the bounding rectangle of its solid pixels and the span of solid pixels of each row,
+    so an overlap test only visits the rows of the intersection of the two bounding rectangles whose spans overlap,
+    and only the words of each row inside the overlapping spans; the other mask's words are shifted into alignment
+    and ANDed with AVX2 or SSE2 kernels when the processor supports them (see Cpu).
+ */
+class CollisionMask {
+public:
+    /**
+        Null constructor.
+     */
+    CollisionMask() :
+        m_width(0),
+        m_height(0),
+        m_stride(0),
+        m_bounds(0, 0, -1, -1)
+    {
+    }
+
+    /**
+        Constructor from bitmap.
+        @param bitmap source bitmap.
+        @param threshold pixels with alpha greater than this value (0 to 255) are solid.
+     */
+    CollisionMask(Bitmap &bitmap, int threshold = 0) : CollisionMask() {
+        create(bitmap, threshold);
+    }
+
+    /**
+        Generates the mask from the alpha channel of a bitmap.
+        @param bitmap source bitmap.
+        @param threshold pixels with alpha greater than this value (0 to 255) are solid.
+        @return false if the bitmap could not be locked; the mask is then empty.
+     */
+    bool create(Bitmap &bitmap, int threshold = 0) {
+        *this = CollisionMask();
+        int width = bitmap.getWidth(), height = bitmap.getHeight();
+        if (width <= 0 || height <= 0) return true;
+
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return false;
+
+        //each row has a zero word before and after it, so shifted reads of the other mask never leave the row
+        m_width = width;
+        m_height = height;
+        m_stride = (width + 63) / 64 + 2;
+        m_bits.assign((size_t)m_stride * height, 0);
+        m_rowLeft.assign(height, width);
+        m_rowRight.assign(height, -1);
+
+        int left = width, top = height, right = -1, bottom = -1;
+        for(int y = 0; y < height; ++y) {
+            const uint8_t *p = (const uint8_t *)region->data + y * region->pitch + 3;
+            uint64_t *row = &m_bits[(size_t)y * m_stride + 1];
+            for(int x = 0; x < width; ++x, p += 4) {
+                if (*p > threshold) {
+                    row[x >> 6] |= (uint64_t)1 << (x & 63);
+                    if (m_rowLeft[y] == width) m_rowLeft[y] = x;
+                    m_rowRight[y] = x;
+                }
+            }
+            if (m_rowRight[y] >= 0) {
+                left = std::min(left, m_rowLeft[y]);
+                right = std::max(right, m_rowRight[y]);
+                if (top == height) top = y;
+                bottom = y;
+            }
+        }
+        if (right >= 0) m_bounds.set(left, top, right, bottom);
+        return true;
+    }
+
+    /**
+        Returns the width.
+        @return the width.
+     */
+    int getWidth() const {
+        return m_width;
+    }
+
+    /**
+        Returns the height.
+        @return the height.
+     */
+    int getHeight() const {
+        return m_height;
+    }
+
+    /**
+        Returns the size.
+        @return the size.
+     */
+    Size<int> getSize() const {
+        return Size<int>(m_width, m_height);
+    }
+
+    /**
+        Checks if the mask has no solid pixels.
+        @return true if empty.
+     */
+    bool isEmpty() const {
+        return m_bounds.getRight() < m_bounds.getLeft();
+    }
+
+    /**
+        Returns the bounding rectangle of the solid pixels, relative to the mask.
+        @return the bounding rectangle; its right is smaller than its left if the mask is empty.
+     */
+    const Rect<int> &getBounds() const {
+        return m_bounds;
+    }
+
+    /**
+        Returns the packed pixels of a row.
+        @param y row.
+        @return (width + 63) / 64 words; bit (x % 64) of word (x / 64) is set for solid pixels.
+     */
+    const uint64_t *getRow(int y) const {
+        return &m_bits[(size_t)y * m_stride + 1];
+    }
+
+    /**
+        Checks if a pixel is solid.
+        @param x horizontal coordinate.
+        @param y vertical coordinate.
+        @return true if the pixel is inside the mask and solid.
+     */
+    bool isSolid(int x, int y) const {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height) return false;
+        return (getRow(y)[x >> 6] >> (x & 63)) & 1;
+    }
+
+    /**
+        Checks if a pixel is solid.
+        @param pt point.
+        @return true if the pixel is inside the mask and solid.
+     */
+    bool isSolid(const Point<int> &pt) const {
+        return isSolid(pt.getX(), pt.getY());
+    }
+
+    /**
+        Checks if solid pixels of this mask and another mask overlap.
+        @param x horizontal position of this mask.
+        @param y vertical position of this mask.
+        @param other other mask.
+        @param otherX horizontal position of the other mask.
+        @param otherY vertical position of the other mask.
+        @return true if at least one pixel is solid in both masks.
+     */
+    bool overlaps(int x, int y, const CollisionMask &other, int otherX, int otherY) const {
+        if (isEmpty() || other.isEmpty()) return false;
+
+        //intersection of the bounding rectangles
+        int left = std::max(x + m_bounds.getLeft(), otherX + other.m_bounds.getLeft());
+        int top = std::max(y + m_bounds.getTop(), otherY + other.m_bounds.getTop());
+        int right = std::min(x + m_bounds.getRight(), otherX + other.m_bounds.getRight());
+        int bottom = std::min(y + m_bounds.getBottom(), otherY + other.m_bounds.getBottom());
+        if (left > right || top > bottom) return false;
+
+        for(int row = top; row <= bottom; ++row) {
+            int ra = row - y, rb = row - otherY;
+            int l = std::max(left, std::max(x + m_rowLeft[ra], otherX + other.m_rowLeft[rb]));
+            int r = std::min(right, std::min(x + m_rowRight[ra], otherX + other.m_rowRight[rb]));
+            if (l > r) continue;
+
+            //words of this row that cover the span, and the bit of the other padded row where the first one starts;
+            //bits outside the span need no masking, since only pixels solid in both rows count
+            int first = (l - x) >> 6, last = (r - x) >> 6;
+            int bit = first * 64 + x - otherX + 64;
+            const uint64_t *a = &m_bits[(size_t)ra * m_stride + 1 + first];
+            const uint64_t *b = &other.m_bits[(size_t)rb * other.m_stride + (bit >> 6)];
+            if (_and(a, b, last - first + 1, bit & 63)) return true;
+        }
+        return false;
+    }
+
+    /**
+        Checks if solid pixels of this mask and another mask overlap.
+        @param pos position of this mask.
+        @param other other mask.
+        @param otherPos position of the other mask.
+        @return true if at least one pixel is solid in both masks.
+     */
+    bool overlaps(const Point<int> &pos, const CollisionMask &other, const Point<int> &otherPos) const {
+        return overlaps(pos.getX(), pos.getY(), other, otherPos.getX(), otherPos.getY());
+    }
+
+private:
+    //size
+    int m_width;
+    int m_height;
+
+    //words per row, including the padding words
+    int m_stride;
+
+    //packed rows
+    std::vector<uint64_t> m_bits;
+
+    //span of solid pixels per row; left is greater than right for empty rows
+    std::vector<int> m_rowLeft;
+    std::vector<int> m_rowRight;
+
+    //bounding rectangle of the solid pixels
+    Rect<int> m_bounds;
+
+    //checks if n words of a overlap n words of b shifted right by the given number of bits
+    static bool _and(const uint64_t *a, const uint64_t *b, size_t n, int shift) {
+        bool hit = false;
+        size_t i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _andAVX2(a, b, n, shift, hit);
+        else if (Cpu::hasSSE2()) i = _andSSE2(a, b, n, shift, hit);
+#endif
+        if (hit) return true;
+        for(; i < n; ++i) {
+            uint64_t word = shift ? (b[i] >> shift) | (b[i + 1] << (64 - shift)) : b[i];
+            if (a[i] & word) return true;
+        }
+        return false;
+    }
+
+#ifdef ALX_X86
+
+    //SSE2 kernels; they return the number of elements processed
+
+    ALX_TARGET_SSE2 static size_t _andSSE2(const uint64_t *a, const uint64_t *b, size_t n, int shift, bool &hit) {
+        //a shift by 64 yields zero, so shift 0 needs no special case
+        const __m128i right = _mm_cvtsi32_si128(shift), left = _mm_cvtsi32_si128(64 - shift);
+        __m128i acc = _mm_setzero_si128();
+        size_t i = 0;
+        for(; i + 2 <= n; i += 2) {
+            __m128i lo = _mm_loadu_si128((const __m128i *)(b + i));
+            __m128i hi = _mm_loadu_si128((const __m128i *)(b + i + 1));
+            __m128i word = _mm_or_si128(_mm_srl_epi64(lo, right), _mm_sll_epi64(hi, left));
+            acc = _mm_or_si128(acc, _mm_and_si128(_mm_loadu_si128((const __m128i *)(a + i)), word));
+        }
+        hit = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xffff;
+        return i;
+    }
+
+    //AVX2 kernels; they return the number of elements processed
+
+    ALX_TARGET_AVX2 static size_t _andAVX2(const uint64_t *a, const uint64_t *b, size_t n, int shift, bool &hit) {
+        const __m128i right = _mm_cvtsi32_si128(shift), left = _mm_cvtsi32_si128(64 - shift);
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m256i lo = _mm256_loadu_si256((const __m256i *)(b + i));
+            __m256i hi = _mm256_loadu_si256((const __m256i *)(b + i + 1));
+            __m256i word = _mm256_or_si256(_mm256_srl_epi64(lo, right), _mm256_sll_epi64(hi, left));
+            acc = _mm256_or_si256(acc, _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(a + i)), word));
+        }
+        hit = !_mm256_testz_si256(acc, acc);
+        return i;
+    }
+
+#endif //ALX_X86
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_COLLISION_MASK_HPP
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <initializer_list>
 #include <allegro5/allegro.h>
+#include "Cpu.hpp"
 
 
 #ifdef min
@@ -22,6 +23,7 @@ namespace alx {
 
 /**
     Color class.
+    Colors built from values or components are constexpr.
  */
 class Color {
 public:
@@ -29,8 +31,7 @@ public:
         Constructor from single 32-bit color value.
         @param value 32-bit color value in the form of 0xAARRGGBB.
      */
-    Color(uint32_t value = 0) {
-        m_color.m_value = value;
+    constexpr Color(uint32_t value = 0) : m_color{value} {
     }
 
     /**
@@ -40,8 +41,9 @@ public:
         @param blue initial value of the blue color component.
         @param alpha initial value of the alpha color component.
      */
-    Color(int red, int green, int blue, int alpha = 255) {
-        set(red, green, blue, alpha);
+    constexpr Color(int red, int green, int blue, int alpha = 255) :
+        m_color{_pack(_int(red), _int(green), _int(blue), _int(alpha))}
+    {
     }
 
     /**
@@ -51,8 +53,9 @@ public:
         @param blue initial value of the blue color component.
         @param alpha initial value of the alpha color component.
      */
-    Color(float red, float green, float blue, float alpha = 1.0f) {
-        set(red, green, blue, alpha);
+    constexpr Color(float red, float green, float blue, float alpha = 1.0f) :
+        m_color{_pack(_floatToInt(red), _floatToInt(green), _floatToInt(blue), _floatToInt(alpha))}
+    {
     }
 
     /**
@@ -81,23 +84,43 @@ public:
     /**
         Copy constructor.
      */
-    Color(const Color &c) {
-        operator = (c);
+    constexpr Color(const Color &c) : m_color(c.m_color) {
     }
 
     /**
-        Converts the internal color components to a color using the function al_map_rgba.
+        Converts the internal color components to an allegro color.
+        The result is the same as the one of al_map_rgba, but it is computed inline with a lookup table.
         @return an allegro color instance.
      */
     operator ALLEGRO_COLOR () const {
-        return al_map_rgba(m_color.m_red, m_color.m_green, m_color.m_blue, m_color.m_alpha);
+        const float *table = _byteToFloat<>::table;
+        ALLEGRO_COLOR color = {table[m_color.m_red], table[m_color.m_green], table[m_color.m_blue], table[m_color.m_alpha]};
+        return color;
+    }
+
+    /**
+        Converts an array of colors to allegro colors, using SIMD kernels when available.
+        The results are the same as the ones of the conversion operator.
+        @param src source colors.
+        @param dst destination allegro colors.
+        @param count number of colors.
+     */
+    static void convert(const Color *src, ALLEGRO_COLOR *dst, size_t count) {
+        size_t i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _convertAVX2(&src->m_color.m_value, &dst->r, count);
+        else if (Cpu::hasSSE2()) i = _convertSSE2(&src->m_color.m_value, &dst->r, count);
+#endif
+        for(; i < count; ++i) {
+            dst[i] = src[i];
+        }
     }
 
     /**
         Conversion to 32-bit value.
         @return a 32-bit value.
      */
-    operator uint32_t () const {
+    constexpr operator uint32_t () const {
         return m_color.m_value;
     }
 
@@ -308,20 +331,30 @@ public:
     }
 
 private:
-    //color
+    //color; the value comes first, so that constexpr constructors initialize it
     union {
+        uint32_t m_value;
         struct {
             uint8_t m_blue;
             uint8_t m_green;
             uint8_t m_red;
             uint8_t m_alpha;
         };
-        uint32_t m_value;
     } m_color;
 
+    //byte to float table; a template, so that it can be defined in this header
+    template <class T = void> struct _byteToFloat {
+        static const float table[256];
+    };
+
+    //packs color components
+    static constexpr uint32_t _pack(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha) {
+        return (alpha << 24) | (red << 16) | (green << 8) | blue;
+    }
+
     //converts float color component to integer
-    static uint8_t _floatToInt(float f) {
-        return 255 * std::max(0.0f, std::min(f, 1.0f));
+    static constexpr uint8_t _floatToInt(float f) {
+        return (uint8_t)(255 * (f < 0.0f ? 0.0f : f > 1.0f ? 1.0f : f));
     }
 
     //converts int color component to float
@@ -330,12 +363,66 @@ private:
     }
 
     //converts nt to color component
-    static uint8_t _int(int c) {
-        return std::max(0, std::min(c, 255));
+    static constexpr uint8_t _int(int c) {
+        return (uint8_t)(c < 0 ? 0 : c > 255 ? 255 : c);
+    }
+
+#ifdef ALX_X86
+
+    //SIMD kernels; they return the number of colors processed; bytes B, G, R, A become floats R, G, B, A
+
+    ALX_TARGET_SSE2 static size_t _convertSSE2(const uint32_t *src, float *dst, size_t count) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale = _mm_set1_ps(255.0f);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+            __m128i c[4] = {_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero), _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+            for(int k = 0; k < 4; ++k) {
+                __m128 f = _mm_div_ps(_mm_cvtepi32_ps(c[k]), scale);
+                _mm_storeu_ps(dst + (i + k) * 4, _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 0, 1, 2)));
+            }
+        }
+        return i;
     }
+
+    ALX_TARGET_AVX2 static size_t _convertAVX2(const uint32_t *src, float *dst, size_t count) {
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        size_t i = 0;
+        for(; i + 2 <= count; i += 2) {
+            __m256i c = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i)));
+            __m256 f = _mm256_div_ps(_mm256_cvtepi32_ps(c), scale);
+            _mm256_storeu_ps(dst + i * 4, _mm256_permute_ps(f, _MM_SHUFFLE(3, 0, 1, 2)));
+        }
+        return i;
+    }
+
+#endif //ALX_X86
 };
 
 
+#define ALX_COLOR_ENTRY(i) (i) / 255.0f
+#define ALX_COLOR_ROW(i) \
+    ALX_COLOR_ENTRY(i +  0), ALX_COLOR_ENTRY(i +  1), ALX_COLOR_ENTRY(i +  2), ALX_COLOR_ENTRY(i +  3), \
+    ALX_COLOR_ENTRY(i +  4), ALX_COLOR_ENTRY(i +  5), ALX_COLOR_ENTRY(i +  6), ALX_COLOR_ENTRY(i +  7), \
+    ALX_COLOR_ENTRY(i +  8), ALX_COLOR_ENTRY(i +  9), ALX_COLOR_ENTRY(i + 10), ALX_COLOR_ENTRY(i + 11), \
+    ALX_COLOR_ENTRY(i + 12), ALX_COLOR_ENTRY(i + 13), ALX_COLOR_ENTRY(i + 14), ALX_COLOR_ENTRY(i + 15)
+
+
+//table of byte / 255 values, as used by al_map_rgba
+template <class T> const float Color::_byteToFloat<T>::table[256] = {
+    ALX_COLOR_ROW(  0), ALX_COLOR_ROW( 16), ALX_COLOR_ROW( 32), ALX_COLOR_ROW( 48),
+    ALX_COLOR_ROW( 64), ALX_COLOR_ROW( 80), ALX_COLOR_ROW( 96), ALX_COLOR_ROW(112),
+    ALX_COLOR_ROW(128), ALX_COLOR_ROW(144), ALX_COLOR_ROW(160), ALX_COLOR_ROW(176),
+    ALX_COLOR_ROW(192), ALX_COLOR_ROW(208), ALX_COLOR_ROW(224), ALX_COLOR_ROW(240)
+};
+
+
+#undef ALX_COLOR_ROW
+#undef ALX_COLOR_ENTRY
+
+
 } //namespace alx
 
 
@@ -0,0 +1,129 @@
+#ifndef ALX_CPU_HPP
+#define ALX_CPU_HPP
+
+
+#if !defined(ALX_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define ALX_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+
+/**
+    Marks a function that uses SSE2 intrinsics.
+ */
+#if defined(ALX_X86) && defined(__GNUC__)
+#define ALX_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define ALX_TARGET_SSE2
+#endif
+
+
+/**
+    Marks a function that uses AVX2 intrinsics;
+    such functions must only be called if Cpu::hasAVX2() returns true.
+ */
+#if defined(ALX_X86) && defined(__GNUC__)
+#define ALX_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ALX_TARGET_AVX2
+#endif
+
+
+namespace alx {
+
+
+/**
+    Runtime detection of the SIMD instruction sets used by the library's bulk kernels.
+    Define ALX_NO_SIMD to compile the scalar code paths only.
+ */
+class Cpu {
+public:
+    /**
+        SIMD levels, in increasing order: plain c++, SSE2 and AVX2 kernels.
+     */
+    enum SimdLevel {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /**
+        Returns the SIMD level the kernels use.
+        It is the highest level supported by the processor, unless lowered with setSimdLevel().
+        @return the SIMD level the kernels use.
+     */
+    static SimdLevel getSimdLevel() {
+        return _level();
+    }
+
+    /**
+        Sets the SIMD level the kernels use; useful for comparing code paths.
+        The level is clamped to the highest level supported by the processor.
+        @param level the requested level.
+     */
+    static void setSimdLevel(SimdLevel level) {
+        _level() = level < _detect() ? level : _detect();
+    }
+
+    /**
+        Checks if the kernels may use SSE2.
+        @return true if SSE2 is available and enabled.
+     */
+    static bool hasSSE2() {
+        return _level() >= SSE2;
+    }
+
+    /**
+        Checks if the kernels may use AVX2.
+        @return true if AVX2 is available and enabled.
+     */
+    static bool hasAVX2() {
+        return _level() >= AVX2;
+    }
+
+private:
+    //the current level
+    static SimdLevel &_level() {
+        static SimdLevel level = _detect();
+        return level;
+    }
+
+    //detects the highest supported level
+    static SimdLevel _detect() {
+#if defined(ALX_X86) && defined(_MSC_VER)
+        static const SimdLevel level = []() {
+            int info[4];
+            __cpuid(info, 0);
+            int maxId = info[0];
+            __cpuid(info, 1);
+            if (!(info[3] & (1 << 26))) return Scalar;
+            bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+            if (osAvx && maxId >= 7) {
+                __cpuidex(info, 7, 0);
+                if (info[1] & (1 << 5)) return AVX2;
+            }
+            return SSE2;
+        }();
+        return level;
+#elif defined(ALX_X86) && defined(__GNUC__)
+        static const SimdLevel level = []() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return AVX2;
+            if (__builtin_cpu_supports("sse2")) return SSE2;
+            return Scalar;
+        }();
+        return level;
+#else
+        return Scalar;
+#endif
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_CPU_HPP
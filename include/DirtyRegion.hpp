@@ -0,0 +1,198 @@
+#ifndef ALX_DIRTY_REGION_HPP
+#define ALX_DIRTY_REGION_HPP
+
+
+#include <vector>
+#include <cstdint>
+#include "Rect.hpp"
+
+
+namespace alx {
+
+
+/**
+    Accumulates invalidated rectangles, so that only the changed parts of a frame are redrawn.
+    Rectangles are merged when the merged rectangle wastes no more than a given number of pixels,
+    which trades a little overdraw for fewer clipped redraw passes; adjacent and overlapping rectangles
+    are therefore usually merged. The number of rectangles is also capped, by merging the cheapest pairs.
+ */
+class DirtyRegion {
+public:
+    /**
+        Constructor.
+        @param bounds the area covered by the region, usually the target bitmap; rectangles are clipped to it.
+        @param maxRects maximum number of rectangles kept.
+        @param mergeCost number of extra pixels one redraw pass is considered to cost; rectangles are merged
+            if the merged rectangle covers at most that many pixels more than the two rectangles.
+     */
+    DirtyRegion(const Rect<int> &bounds, size_t maxRects = 16, int64_t mergeCost = 4096) :
+        m_bounds(bounds),
+        m_maxRects(maxRects > 0 ? maxRects : 1),
+        m_mergeCost(mergeCost)
+    {
+    }
+
+    /**
+        Returns the bounds.
+        @return the bounds.
+     */
+    const Rect<int> &getBounds() const {
+        return m_bounds;
+    }
+
+    /**
+        Sets the bounds and clears the region.
+        @param bounds new bounds.
+     */
+    void setBounds(const Rect<int> &bounds) {
+        m_bounds = bounds;
+        m_rects.clear();
+    }
+
+    /**
+        Invalidates a rectangle.
+        @param rect rectangle.
+     */
+    void add(const Rect<int> &rect) {
+        Rect<int> r = rect & m_bounds;
+        if (!r.isNormalized()) return;
+
+        //merge with existing rectangles while it pays off; a merged rectangle may now merge with others
+        for(size_t i = 0; i < m_rects.size(); ) {
+            if (_waste(m_rects[i], r) <= m_mergeCost) {
+                r |= m_rects[i];
+                m_rects.erase(m_rects.begin() + i);
+                i = 0;
+            }
+            else {
+                ++i;
+            }
+        }
+        m_rects.push_back(r);
+
+        //enforce the rectangle limit
+        while (m_rects.size() > m_maxRects) {
+            size_t bestA = 0, bestB = 1;
+            int64_t bestWaste = INT64_MAX;
+            for(size_t a = 0; a < m_rects.size(); ++a) {
+                for(size_t b = a + 1; b < m_rects.size(); ++b) {
+                    int64_t waste = _waste(m_rects[a], m_rects[b]);
+                    if (waste < bestWaste) {
+                        bestWaste = waste;
+                        bestA = a;
+                        bestB = b;
+                    }
+                }
+            }
+            m_rects[bestA] |= m_rects[bestB];
+            m_rects.erase(m_rects.begin() + bestB);
+        }
+    }
+
+    /**
+        Invalidates a rectangle.
+        @param pt top-left point.
+        @param size size.
+     */
+    void add(const Point<int> &pt, const Size<int> &size) {
+        add(Rect<int>(pt, size));
+    }
+
+    /**
+        Invalidates the whole bounds.
+     */
+    void addAll() {
+        m_rects.assign(1, m_bounds);
+    }
+
+    /**
+        Clears the region; usually called after redrawing.
+     */
+    void clear() {
+        m_rects.clear();
+    }
+
+    /**
+        Checks if nothing is invalidated.
+        @return true if empty.
+     */
+    bool isEmpty() const {
+        return m_rects.empty();
+    }
+
+    /**
+        Returns the invalidated rectangles; they may overlap slightly.
+        @return the invalidated rectangles.
+     */
+    const std::vector<Rect<int>> &getRects() const {
+        return m_rects;
+    }
+
+    /**
+        Returns the number of pixels the rectangles cover, i.e. the pixels touched by a redraw.
+        @return the number of pixels covered.
+     */
+    int64_t getArea() const {
+        int64_t area = 0;
+        for(const Rect<int> &r : m_rects) {
+            area += _area(r);
+        }
+        return area;
+    }
+
+    /**
+        Checks if a rectangle intersects the region; useful for skipping widgets that need not be drawn.
+        @param rect rectangle.
+        @return true if the rectangle intersects any invalidated rectangle.
+     */
+    bool intersects(const Rect<int> &rect) const {
+        for(const Rect<int> &r : m_rects) {
+            if (r.intersects(rect)) return true;
+        }
+        return false;
+    }
+
+    /**
+        Redraws the region: for each rectangle, the clipping of the target bitmap is set to it and the function is called.
+        The clipping is restored afterwards, and the region is cleared.
+        @param draw function with the signature draw(const Rect<int> &rect).
+     */
+    template <class F> void redraw(F draw) {
+        Rect<int> clipping = Rect<int>::getClipping();
+        for(const Rect<int> &r : m_rects) {
+            r.setClipping();
+            draw(r);
+        }
+        clipping.setClipping();
+        m_rects.clear();
+    }
+
+private:
+    //bounds
+    Rect<int> m_bounds;
+
+    //settings
+    size_t m_maxRects;
+    int64_t m_mergeCost;
+
+    //rectangles
+    std::vector<Rect<int>> m_rects;
+
+    //area of a rectangle
+    static int64_t _area(const Rect<int> &r) {
+        return (int64_t)r.getWidth() * r.getHeight();
+    }
+
+    //pixels the union of two rectangles covers beyond the rectangles themselves
+    static int64_t _waste(const Rect<int> &a, const Rect<int> &b) {
+        Rect<int> i = a & b;
+        int64_t overlap = i.isNormalized() ? _area(i) : 0;
+        return _area(a | b) - (_area(a) + _area(b) - overlap);
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_DIRTY_REGION_HPP
@@ -199,6 +199,13 @@ public:
         al_set_target_backbuffer(display.get());
     }
 
+    /**
+        Flips the backbuffer of the current display.
+     */
+    static void flip() {
+        al_flip_display();
+    }
+
     /**
         Returns the current display.
         @return the current display.
@@ -0,0 +1,751 @@
+#ifndef ALX_DRAW_LIST_HPP
+#define ALX_DRAW_LIST_HPP
+
+
+#include <vector>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <allegro5/allegro_primitives.h>
+#include "Bitmap.hpp"
+#include "Font.hpp"
+#include "State.hpp"
+#include "String.hpp"
+
+
+namespace alx {
+
+
+/**
+    A list of recorded draw commands, replayed later in state-sorted order.
+    Bitmap, text and primitive calls are recorded as plain data instead of being executed, so a list
+    can be built on any thread and submitted on the display thread. Each command is a small fixed-size sort record
+    with its arguments in a separate byte stream, encoded per kind: untinted quads store no color, unrotated quads
+    no matrix, and text only its bytes. All the Font::draw and drawf variants have a recording counterpart.
+    At submission, the commands are sorted by layer,
+    then texture, then blender (keeping the recording order otherwise), and runs of compatible commands are merged:
+    bitmap quads sharing a texture and untextured rectangles and lines become one primitive call each,
+    and text runs sharing a font are drawn with held bitmap drawing.
+    The list stores raw Allegro pointers: the bitmaps and fonts must stay alive until the list is submitted.
+    Coordinates are submitted through the target's current transform.
+ */
+class DrawList {
+public:
+    /**
+        Constructor.
+        The initial layer is 0 and the initial blender is Allegro's default premultiplied alpha blender.
+     */
+    DrawList() :
+        m_layer(0),
+        m_blend(_packBlend(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA)),
+        m_submittedCount(0)
+    {
+    }
+
+    /**
+        Returns the layer of the next commands.
+        @return the current layer.
+     */
+    int getLayer() const {
+        return m_layer;
+    }
+
+    /**
+        Sets the layer of the next commands; lower layers are drawn first.
+        @param layer layer.
+     */
+    void setLayer(int layer) {
+        m_layer = layer;
+    }
+
+    /**
+        Sets the blender of the next commands.
+        @param op operation.
+        @param src source factor.
+        @param dst destination factor.
+     */
+    void setBlender(int op, int src, int dst) {
+        m_blend = _packBlend(op, src, dst);
+    }
+
+    /**
+        Records drawing a bitmap.
+        @param bitmap bitmap.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void draw(const Bitmap &bitmap, float dx, float dy, int flags = 0) {
+        float w = (float)bitmap.getWidth(), h = (float)bitmap.getHeight();
+        _addBitmap(bitmap, _white(), 0, 0, w, h, dx, dy, w, h, flags);
+    }
+
+    /**
+        Records drawing part of a bitmap.
+        @param bitmap bitmap.
+        @param sx source x position.
+        @param sy source y position.
+        @param sw source width.
+        @param sh source height.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void draw(const Bitmap &bitmap, float sx, float sy, float sw, float sh, float dx, float dy, int flags = 0) {
+        _addBitmap(bitmap, _white(), sx, sy, sw, sh, dx, dy, sw, sh, flags);
+    }
+
+    /**
+        Records drawing a tinted bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void drawTinted(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float dx, float dy, int flags = 0) {
+        float w = (float)bitmap.getWidth(), h = (float)bitmap.getHeight();
+        _addBitmap(bitmap, color, 0, 0, w, h, dx, dy, w, h, flags);
+    }
+
+    /**
+        Records drawing a tinted part of a bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param sx source x position.
+        @param sy source y position.
+        @param sw source width.
+        @param sh source height.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void drawTinted(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, int flags = 0) {
+        _addBitmap(bitmap, color, sx, sy, sw, sh, dx, dy, sw, sh, flags);
+    }
+
+    /**
+        Records drawing a scaled bitmap.
+        @param bitmap bitmap.
+        @param sx source x.
+        @param sy source y.
+        @param sw source width.
+        @param sh source height.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawScaled(const Bitmap &bitmap, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags = 0) {
+        _addBitmap(bitmap, _white(), sx, sy, sw, sh, dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Records drawing a tinted scaled bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param sx source x.
+        @param sy source y.
+        @param sw source width.
+        @param sh source height.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawTintedScaled(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags = 0) {
+        _addBitmap(bitmap, color, sx, sy, sw, sh, dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Records drawing a rotated bitmap.
+        @param bitmap bitmap.
+        @param cx center x relative to the left of the bitmap.
+        @param cy center y relative to the top of the bitmap.
+        @param dx destination x.
+        @param dy destination y.
+        @param angle angle in radians.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawRotated(const Bitmap &bitmap, float cx, float cy, float dx, float dy, float angle, int flags = 0) {
+        drawScaledRotated(bitmap, _white(), cx, cy, dx, dy, 1, 1, angle, flags);
+    }
+
+    /**
+        Records drawing a scaled and rotated bitmap.
+        @param bitmap bitmap.
+        @param cx center x relative to the left of the bitmap.
+        @param cy center y relative to the top of the bitmap.
+        @param dx destination x.
+        @param dy destination y.
+        @param xscale horizontal scale.
+        @param yscale vertical scale.
+        @param angle angle in radians.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawScaledRotated(const Bitmap &bitmap, float cx, float cy, float dx, float dy, float xscale, float yscale, float angle, int flags = 0) {
+        drawScaledRotated(bitmap, _white(), cx, cy, dx, dy, xscale, yscale, angle, flags);
+    }
+
+    /**
+        Records drawing a tinted, scaled and rotated bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param cx center x relative to the left of the bitmap.
+        @param cy center y relative to the top of the bitmap.
+        @param dx destination x.
+        @param dy destination y.
+        @param xscale horizontal scale.
+        @param yscale vertical scale.
+        @param angle angle in radians.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawScaledRotated(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float cx, float cy, float dx, float dy, float xscale, float yscale, float angle, int flags = 0) {
+        float c = std::cos(angle), s = std::sin(angle);
+        float m[6] = {c * xscale, -s * yscale, dx, s * xscale, c * yscale, dy};
+        float w = (float)bitmap.getWidth(), h = (float)bitmap.getHeight();
+        _addBitmap(bitmap, color, 0, 0, w, h, -cx, -cy, w, h, flags, m);
+    }
+
+    /**
+        Records drawing text.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param flags flags.
+        @param color color.
+        @param text null-terminated string to draw; it is copied.
+     */
+    void drawText(const Font &font, float x, float y, int flags, const ALLEGRO_COLOR &color, const char *text) {
+        _addText(font, x, y, flags, color, text, strlen(text));
+    }
+
+    /**
+        Records drawing text, with flags = 0.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param color color.
+        @param text null-terminated string to draw; it is copied.
+     */
+    void drawText(const Font &font, float x, float y, const ALLEGRO_COLOR &color, const char *text) {
+        drawText(font, x, y, 0, color, text);
+    }
+
+    /**
+        Records drawing text.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param flags flags.
+        @param color color.
+        @param text string to draw; it is copied.
+     */
+    void drawText(const Font &font, float x, float y, int flags, const ALLEGRO_COLOR &color, const String &text) {
+        _addText(font, x, y, flags, color, text.cstr(), text.getSize());
+    }
+
+    /**
+        Records drawing text, with flags = 0.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param color color.
+        @param text string to draw; it is copied.
+     */
+    void drawText(const Font &font, float x, float y, const ALLEGRO_COLOR &color, const String &text) {
+        drawText(font, x, y, 0, color, text);
+    }
+
+    /**
+        Records drawing printf-style text; the text is formatted when recorded.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param flags flags.
+        @param color color.
+        @param format printf-style format.
+        @param ... printf-style arguments.
+     */
+    void drawTextf(const Font &font, float x, float y, int flags, const ALLEGRO_COLOR &color, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        drawTextf(font, x, y, flags, color, format, args);
+        va_end(args);
+    }
+
+    /**
+        Records drawing printf-style text, with flags = 0; the text is formatted when recorded.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param color color.
+        @param format printf-style format.
+        @param ... printf-style arguments.
+     */
+    void drawTextf(const Font &font, float x, float y, const ALLEGRO_COLOR &color, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        drawTextf(font, x, y, 0, color, format, args);
+        va_end(args);
+    }
+
+    /**
+        Records drawing printf-style text; the text is formatted when recorded.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param flags flags.
+        @param color color.
+        @param format printf-style format.
+        @param args arguments.
+     */
+    void drawTextf(const Font &font, float x, float y, int flags, const ALLEGRO_COLOR &color, const char *format, va_list args) {
+        String str;
+        if (!str.printf(format, args)) str = "printf error";
+        drawText(font, x, y, flags, color, str);
+    }
+
+    /**
+        Records drawing printf-style text, with flags = 0; the text is formatted when recorded.
+        @param font font.
+        @param x target x coordinate.
+        @param y target y coordinate.
+        @param color color.
+        @param format printf-style format.
+        @param args arguments.
+     */
+    void drawTextf(const Font &font, float x, float y, const ALLEGRO_COLOR &color, const char *format, va_list args) {
+        drawTextf(font, x, y, 0, color, format, args);
+    }
+
+    /**
+        Records drawing a line.
+        @param x1 x of the first point.
+        @param y1 y of the first point.
+        @param x2 x of the second point.
+        @param y2 y of the second point.
+        @param color color.
+        @param thickness thickness; values below 1 draw 1 pixel wide lines.
+     */
+    void drawLine(float x1, float y1, float x2, float y2, const ALLEGRO_COLOR &color, float thickness = 1) {
+        _addPrimitive(Line, color, x1, y1, x2, y2, thickness);
+    }
+
+    /**
+        Records drawing the outline of a rectangle.
+        @param x1 left.
+        @param y1 top.
+        @param x2 right.
+        @param y2 bottom.
+        @param color color.
+        @param thickness thickness; values below 1 draw 1 pixel wide lines.
+     */
+    void drawRectangle(float x1, float y1, float x2, float y2, const ALLEGRO_COLOR &color, float thickness = 1) {
+        _addPrimitive(Rectangle, color, x1, y1, x2, y2, thickness);
+    }
+
+    /**
+        Records drawing a filled rectangle.
+        @param x1 left.
+        @param y1 top.
+        @param x2 right.
+        @param y2 bottom.
+        @param color color.
+     */
+    void drawFilledRectangle(float x1, float y1, float x2, float y2, const ALLEGRO_COLOR &color) {
+        _addPrimitive(FilledRectangle, color, x1, y1, x2, y2, 0);
+    }
+
+    /**
+        Records drawing the outline of a circle.
+        @param cx center x.
+        @param cy center y.
+        @param r radius.
+        @param color color.
+        @param thickness thickness; 0 or less draws a hairline.
+     */
+    void drawCircle(float cx, float cy, float r, const ALLEGRO_COLOR &color, float thickness = 1) {
+        _addPrimitive(Circle, color, cx, cy, r, 0, thickness);
+    }
+
+    /**
+        Records drawing a filled circle.
+        @param cx center x.
+        @param cy center y.
+        @param r radius.
+        @param color color.
+     */
+    void drawFilledCircle(float cx, float cy, float r, const ALLEGRO_COLOR &color) {
+        _addPrimitive(FilledCircle, color, cx, cy, r, 0, 0);
+    }
+
+    /**
+        Draws the recorded commands onto the target bitmap; the list is kept, so it can be submitted again.
+        The blender is restored afterwards.
+     */
+    void submit() {
+        m_submittedCount = 0;
+        if (m_commands.empty()) return;
+
+        //the sort is stable, so sorting in place keeps the recording order of equal keys across submissions
+        std::stable_sort(m_commands.begin(), m_commands.end(), [](const Command &a, const Command &b) {
+            if (a.layer != b.layer) return a.layer < b.layer;
+            if (a.texture != b.texture) return a.texture < b.texture;
+            return a.blend < b.blend;
+        });
+
+        State state;
+        state.retrieve(ALLEGRO_STATE_BLENDER);
+        uint32_t blend = 0xffffffff;
+        for(size_t begin = 0; begin < m_commands.size(); ) {
+            const Command &first = m_commands[begin];
+            size_t end = begin + 1;
+            for(; end < m_commands.size(); ++end) {
+                const Command &cmd = m_commands[end];
+                if (cmd.layer != first.layer || cmd.texture != first.texture || cmd.blend != first.blend) break;
+            }
+            if (first.blend != blend) {
+                blend = first.blend;
+                al_set_blender(blend >> 16, (blend >> 8) & 0xff, blend & 0xff);
+            }
+            if (first.type == Text) {
+                _submitText(begin, end);
+            }
+            else {
+                _submitPrimitives(begin, end);
+            }
+            begin = end;
+        }
+        state.restore();
+    }
+
+    /**
+        Removes all commands and resets the layer and blender.
+     */
+    void clear() {
+        m_commands.clear();
+        m_data.clear();
+        m_layer = 0;
+        m_blend = _packBlend(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+    }
+
+    /**
+        Checks if the list has no commands.
+        @return true if empty.
+     */
+    bool isEmpty() const {
+        return m_commands.empty();
+    }
+
+    /**
+        Returns the number of recorded draw commands.
+        @return the number of recorded draw commands.
+     */
+    size_t getRecordedCount() const {
+        return m_commands.size();
+    }
+
+    /**
+        Returns the memory used by the recorded commands and their arguments.
+        @return the size of the recorded commands, in bytes.
+     */
+    size_t getRecordedSize() const {
+        return m_commands.size() * sizeof(Command) + m_data.size();
+    }
+
+    /**
+        Returns the number of draw calls issued by the last submission.
+        @return the number of submitted draw calls.
+     */
+    size_t getSubmittedCount() const {
+        return m_submittedCount;
+    }
+
+private:
+    //command types
+    enum Type {
+        Quad,
+        Text,
+        Line,
+        Rectangle,
+        FilledRectangle,
+        Circle,
+        FilledCircle
+    };
+
+    //a recorded command: the sort keys and the offset of the arguments in the data stream;
+    //the arguments depend on the type:
+    //quads: source x, y, w, h, destination x, y, w, h, then the color if _tinted and a 2x3 matrix if _transformed;
+    //text: x, y, flags, color, byte count and bytes;
+    //lines, rectangles and circles: coordinates, thickness, color; filled shapes: coordinates, color
+    struct Command {
+        const void *texture;
+        int32_t layer;
+        uint32_t blend;
+        uint32_t offset;
+        uint8_t type;
+        uint8_t bits;
+    };
+
+    //quad bits
+    static const uint8_t _flipHorizontal = 1;
+    static const uint8_t _flipVertical = 2;
+    static const uint8_t _tinted = 4;
+    static const uint8_t _transformed = 8;
+
+    //reads the arguments of a command
+    class Reader {
+    public:
+        Reader(const uint8_t *p) : m_p(p) {
+        }
+
+        template <class T> T get() {
+            T v;
+            memcpy(&v, m_p, sizeof(T));
+            m_p += sizeof(T);
+            return v;
+        }
+
+        void get(float *v, size_t count) {
+            memcpy(v, m_p, count * sizeof(float));
+            m_p += count * sizeof(float);
+        }
+
+        const char *bytes(size_t size) {
+            const char *result = (const char *)m_p;
+            m_p += size;
+            return result;
+        }
+
+    private:
+        const uint8_t *m_p;
+    };
+
+    //recording state
+    int m_layer;
+    uint32_t m_blend;
+
+    //commands and their arguments
+    std::vector<Command> m_commands;
+    std::vector<uint8_t> m_data;
+
+    //submission scratch buffer
+    std::vector<ALLEGRO_VERTEX> m_vertices;
+
+    //counters
+    size_t m_submittedCount;
+
+    //the default tint
+    static ALLEGRO_COLOR _white() {
+        ALLEGRO_COLOR color = {1, 1, 1, 1};
+        return color;
+    }
+
+    //blender key
+    static uint32_t _packBlend(int op, int src, int dst) {
+        return ((uint32_t)op << 16) | ((uint32_t)src << 8) | (uint32_t)dst;
+    }
+
+    //adds a command with the current state; its arguments are appended next
+    void _add(Type type, const void *texture, uint8_t bits = 0) {
+        Command cmd = {texture, m_layer, m_blend, (uint32_t)m_data.size(), (uint8_t)type, bits};
+        m_commands.push_back(cmd);
+    }
+
+    //appends arguments
+    void _put(const void *data, size_t size) {
+        const uint8_t *p = (const uint8_t *)data;
+        m_data.insert(m_data.end(), p, p + size);
+    }
+
+    template <class T> void _put(const T &v) {
+        _put(&v, sizeof(T));
+    }
+
+    //adds a bitmap quad; the destination rect is optionally mapped through the 2x3 matrix m
+    void _addBitmap(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags, const float *m = nullptr) {
+        //resolve sub-bitmaps to the bitmap that owns the texture
+        ALLEGRO_BITMAP *texture = bitmap.get();
+        while (ALLEGRO_BITMAP *parent = al_get_parent_bitmap(texture)) {
+            sx += al_get_bitmap_x(texture);
+            sy += al_get_bitmap_y(texture);
+            texture = parent;
+        }
+
+        bool tinted = color.r != 1 || color.g != 1 || color.b != 1 || color.a != 1;
+        uint8_t bits =
+            (flags & ALLEGRO_FLIP_HORIZONTAL ? _flipHorizontal : 0) |
+            (flags & ALLEGRO_FLIP_VERTICAL ? _flipVertical : 0) |
+            (tinted ? _tinted : 0) |
+            (m ? _transformed : 0);
+        _add(Quad, texture, bits);
+        float p[8] = {sx, sy, sw, sh, dx, dy, dw, dh};
+        _put(p);
+        if (tinted) _put(color);
+        if (m) _put(m, 6 * sizeof(float));
+    }
+
+    //adds text; the text does not need to be null-terminated
+    void _addText(const Font &font, float x, float y, int flags, const ALLEGRO_COLOR &color, const char *text, size_t size) {
+        _add(Text, font.get());
+        _put(x);
+        _put(y);
+        _put((int32_t)flags);
+        _put(color);
+        _put((uint32_t)size);
+        _put(text, size);
+    }
+
+    //adds a primitive; filled shapes store no thickness, circles no fourth coordinate
+    void _addPrimitive(Type type, const ALLEGRO_COLOR &color, float a, float b, float c, float d, float thickness) {
+        _add(type, nullptr);
+        _put(a);
+        _put(b);
+        _put(c);
+        if (type != Circle && type != FilledCircle) _put(d);
+        if (type != FilledRectangle && type != FilledCircle) _put(thickness);
+        _put(color);
+    }
+
+    //appends a quad as two triangles
+    void _addQuad(const float *x, const float *y, const float *u, const float *v, const ALLEGRO_COLOR &color) {
+        static const int corners[6] = {0, 1, 2, 0, 2, 3};
+        for(int i : corners) {
+            ALLEGRO_VERTEX vtx = {x[i], y[i], 0, u ? u[i] : 0, v ? v[i] : 0, color};
+            m_vertices.push_back(vtx);
+        }
+    }
+
+    //appends an untextured rectangle
+    void _addRect(float x1, float y1, float x2, float y2, const ALLEGRO_COLOR &color) {
+        float x[4] = {x1, x2, x2, x1};
+        float y[4] = {y1, y1, y2, y2};
+        _addQuad(x, y, nullptr, nullptr, color);
+    }
+
+    //appends a line as a quad
+    void _addLine(float x1, float y1, float x2, float y2, float thickness, const ALLEGRO_COLOR &color) {
+        float dx = x2 - x1, dy = y2 - y1, len = std::sqrt(dx * dx + dy * dy);
+        if (len == 0) return;
+        float t = std::max(thickness, 1.0f) / 2, nx = -dy / len * t, ny = dx / len * t;
+        float x[4] = {x1 + nx, x2 + nx, x2 - nx, x1 - nx};
+        float y[4] = {y1 + ny, y2 + ny, y2 - ny, y1 - ny};
+        _addQuad(x, y, nullptr, nullptr, color);
+    }
+
+    //draws the accumulated triangles
+    void _flushVertices(ALLEGRO_BITMAP *texture) {
+        if (m_vertices.empty()) return;
+        al_draw_prim(m_vertices.data(), nullptr, texture, 0, (int)m_vertices.size(), ALLEGRO_PRIM_TRIANGLE_LIST);
+        m_vertices.clear();
+        ++m_submittedCount;
+    }
+
+    //submits a run of text commands sharing a font
+    void _submitText(size_t begin, size_t end) {
+        al_hold_bitmap_drawing(true);
+        for(size_t i = begin; i < end; ++i) {
+            const Command &cmd = m_commands[i];
+            Reader in(&m_data[cmd.offset]);
+            float x = in.get<float>(), y = in.get<float>();
+            int flags = in.get<int32_t>();
+            ALLEGRO_COLOR color = in.get<ALLEGRO_COLOR>();
+            uint32_t size = in.get<uint32_t>();
+            ALLEGRO_USTR_INFO info;
+            al_draw_ustr((const ALLEGRO_FONT *)cmd.texture, color, x, y, flags, al_ref_buffer(&info, in.bytes(size), size));
+        }
+        al_hold_bitmap_drawing(false);
+        ++m_submittedCount;
+    }
+
+    //submits a run of quads sharing a texture, or a run of untextured primitives
+    void _submitPrimitives(size_t begin, size_t end) {
+        ALLEGRO_BITMAP *texture = (ALLEGRO_BITMAP *)m_commands[begin].texture;
+        for(size_t i = begin; i < end; ++i) {
+            const Command &cmd = m_commands[i];
+            Reader in(&m_data[cmd.offset]);
+            switch (cmd.type) {
+                case Quad: {
+                    float p[8];
+                    in.get(p, 8);
+                    ALLEGRO_COLOR color = cmd.bits & _tinted ? in.get<ALLEGRO_COLOR>() : _white();
+                    float u0 = p[0], u1 = p[0] + p[2], v0 = p[1], v1 = p[1] + p[3];
+                    if (cmd.bits & _flipHorizontal) std::swap(u0, u1);
+                    if (cmd.bits & _flipVertical) std::swap(v0, v1);
+                    float x[4] = {p[4], p[4] + p[6], p[4] + p[6], p[4]};
+                    float y[4] = {p[5], p[5], p[5] + p[7], p[5] + p[7]};
+                    float u[4] = {u0, u1, u1, u0};
+                    float v[4] = {v0, v0, v1, v1};
+                    if (cmd.bits & _transformed) {
+                        float m[6];
+                        in.get(m, 6);
+                        for(int k = 0; k < 4; ++k) {
+                            float tx = m[0] * x[k] + m[1] * y[k] + m[2];
+                            y[k] = m[3] * x[k] + m[4] * y[k] + m[5];
+                            x[k] = tx;
+                        }
+                    }
+                    _addQuad(x, y, u, v, color);
+                    break;
+                }
+
+                case Line: {
+                    float p[5];
+                    in.get(p, 5);
+                    _addLine(p[0], p[1], p[2], p[3], p[4], in.get<ALLEGRO_COLOR>());
+                    break;
+                }
+
+                case Rectangle: {
+                    float p[5];
+                    in.get(p, 5);
+                    ALLEGRO_COLOR color = in.get<ALLEGRO_COLOR>();
+                    float t = std::max(p[4], 1.0f) / 2;
+                    _addRect(p[0] - t, p[1] - t, p[2] + t, p[1] + t, color);
+                    _addRect(p[0] - t, p[3] - t, p[2] + t, p[3] + t, color);
+                    _addRect(p[0] - t, p[1] + t, p[0] + t, p[3] - t, color);
+                    _addRect(p[2] - t, p[1] + t, p[2] + t, p[3] - t, color);
+                    break;
+                }
+
+                case FilledRectangle: {
+                    float p[4];
+                    in.get(p, 4);
+                    _addRect(p[0], p[1], p[2], p[3], in.get<ALLEGRO_COLOR>());
+                    break;
+                }
+
+                //circles are drawn by Allegro, after the triangles before them
+                case Circle: {
+                    float p[4];
+                    in.get(p, 4);
+                    _flushVertices(texture);
+                    al_draw_circle(p[0], p[1], p[2], in.get<ALLEGRO_COLOR>(), p[3]);
+                    ++m_submittedCount;
+                    break;
+                }
+
+                case FilledCircle: {
+                    float p[3];
+                    in.get(p, 3);
+                    _flushVertices(texture);
+                    al_draw_filled_circle(p[0], p[1], p[2], in.get<ALLEGRO_COLOR>());
+                    ++m_submittedCount;
+                    break;
+                }
+            }
+        }
+        _flushVertices(texture);
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_DRAW_LIST_HPP
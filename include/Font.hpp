@@ -283,6 +283,39 @@ public:
         return (bool)(*this);
     }
 
+    /**
+        loads a true-type font from memory, for example from a memory-mapped pack.
+        The font is read through a memfile over the buffer, which is not copied and must therefore outlive the font.
+        @param data data.
+        @param dataSize size of the data, in bytes.
+        @param size size in points.
+        @param flags font flags.
+        @return true on success.
+     */
+    bool loadFromMemory(const void *data, size_t dataSize, int size, int flags = 0) {
+        //the font takes ownership of the memfile
+        ALLEGRO_FILE *file = al_open_memfile((void *)data, dataSize, "r");
+        if (!file) return false;
+        reset(al_load_ttf_font_f(file, nullptr, size, flags), al_destroy_font);
+        return (bool)(*this);
+    }
+
+    /**
+        Creates a bitmap font from a glyph sheet in memory, loaded with Bitmap::loadFromMemory();
+        once RawBitmap::registerFormat() is called, raw bitmaps are decoded straight from the buffer.
+        @param data data.
+        @param dataSize size of the data, in bytes.
+        @param ranges ranges.
+        @param ext filename extension of the sheet's format; if null, Allegro identifies the format from the data,
+            which for raw bitmaps also requires RawBitmap::registerFormat().
+        @return true on success.
+     */
+    bool loadFromMemory(const void *data, size_t dataSize, const std::vector<std::tuple<int, int>> &ranges, const char *ext = nullptr) {
+        Bitmap bmp;
+        if (!bmp.loadFromMemory(data, dataSize, ext)) return false;
+        return grab(bmp, ranges);
+    }
+
     /**
         Creates a font from a bitmap.
         @param bmp bitmap.
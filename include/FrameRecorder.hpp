@@ -0,0 +1,348 @@
+#ifndef ALX_FRAME_RECORDER_HPP
+#define ALX_FRAME_RECORDER_HPP
+
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "Bitmap.hpp"
+#include "Display.hpp"
+#include "File.hpp"
+#include "State.hpp"
+#include "Thread.hpp"
+#include "Condition.hpp"
+
+
+namespace alx {
+
+
+/**
+    Records frames without stalling the render loop.
+    capture() copies the backbuffer (or any bitmap) into the next free memory bitmap of a fixed ring;
+    a background thread encodes the queued frames, either as a numbered sequence of image files
+    or as a single Y4M video stream (uncompressed 4:4:4 YUV, readable by most video tools).
+    When the encoder falls behind and the ring is full, frames are dropped and counted instead of waiting.
+    The ring bitmaps are kept between recordings.
+ */
+class FrameRecorder {
+public:
+    /**
+        Output format: Images (one image file per frame, e.g. PNG; requires the image addon) or Y4M (one video file).
+     */
+    enum Format {
+        Images,
+        Y4M
+    };
+
+    /**
+        Constructor.
+        @param ringSize number of frames that can wait for encoding.
+     */
+    FrameRecorder(int ringSize = 8) :
+        m_slots(std::max(ringSize, 1)),
+        m_format(Images),
+        m_fps(60),
+        m_recording(false),
+        m_stop(false),
+        m_next(0),
+        m_frame(0),
+        m_width(0),
+        m_height(0),
+        m_capturedCount(0),
+        m_encodedCount(0),
+        m_droppedCount(0),
+        m_failedCount(0)
+    {
+    }
+
+    /**
+        Destructor.
+        Stops recording.
+     */
+    ~FrameRecorder() {
+        stop();
+    }
+
+    /**
+        Starts recording; a recording in progress is stopped first.
+        @param path for Images, the prefix of the filenames, to which the frame number and the extension are appended;
+            for Y4M, the filename of the video.
+        @param format output format.
+        @param fps frame rate written in the Y4M header.
+        @param extension extension of the image files, which selects their format.
+        @return true on success, false if the video file could not be created.
+     */
+    bool start(const char *path, Format format = Images, int fps = 60, const char *extension = ".png") {
+        stop();
+        if (format == Y4M) {
+            m_file = File(path, "wb");
+            if (!m_file) return false;
+        }
+        m_path = path;
+        m_extension = extension;
+        m_format = format;
+        m_fps = fps;
+        m_frame = 0;
+        m_width = 0;
+        m_height = 0;
+        m_stop = false;
+        m_recording = true;
+        m_thread = Thread([this]() { return _work(); });
+        m_thread.start();
+        return true;
+    }
+
+    /**
+        Stops recording; waits until the queued frames are encoded.
+     */
+    void stop() {
+        if (!m_recording) return;
+        m_mutex.lock();
+        m_stop = true;
+        m_condition.wakeAll();
+        m_mutex.unlock();
+        m_thread.wait();
+        m_thread.reset();
+        m_file.reset();
+        m_recording = false;
+    }
+
+    /**
+        Checks if recording is in progress.
+        @return true if recording.
+     */
+    bool isRecording() const {
+        return m_recording;
+    }
+
+    /**
+        Captures a frame from a bitmap; for Y4M, all frames must have the size of the first one.
+        @param source source bitmap, usually the backbuffer, after drawing and before flipping.
+        @return true if the frame was queued, false if it was dropped or recording is not in progress.
+     */
+    bool capture(Bitmap &source) {
+        if (!m_recording) return false;
+        int width = source.getWidth(), height = source.getHeight();
+
+        Slot *slot;
+        {
+            Lock<Mutex> lock(m_mutex);
+            slot = &m_slots[m_next];
+            if (slot->queued || (m_format == Y4M && m_width && (width != m_width || height != m_height))) {
+                ++m_droppedCount;
+                return false;
+            }
+        }
+
+        //the slot is not queued, so the encoder does not use it
+        if (!slot->bitmap || slot->bitmap.getWidth() != width || slot->bitmap.getHeight() != height) {
+            State state;
+            state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+            al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+            al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+            slot->bitmap = Bitmap(width, height);
+            state.restore();
+        }
+        if (!slot->bitmap || !_copy(slot->bitmap, source)) {
+            Lock<Mutex> lock(m_mutex);
+            ++m_droppedCount;
+            return false;
+        }
+
+        Lock<Mutex> lock(m_mutex);
+        m_width = width;
+        m_height = height;
+        slot->queued = true;
+        slot->frame = m_frame++;
+        m_queue.push_back(m_next);
+        m_next = (m_next + 1) % m_slots.size();
+        ++m_capturedCount;
+        m_condition.wakeOne();
+        return true;
+    }
+
+    /**
+        Captures a frame from the backbuffer of a display.
+        @param display display.
+        @return true if the frame was queued, false if it was dropped or recording is not in progress.
+     */
+    bool capture(const Display &display) {
+        Bitmap backbuffer = display.getBackbuffer();
+        return capture(backbuffer);
+    }
+
+    /**
+        Returns the number of frames queued for encoding.
+        @return the number of frames captured.
+     */
+    size_t getCapturedCount() const {
+        Lock<Mutex> lock(m_mutex);
+        return m_capturedCount;
+    }
+
+    /**
+        Returns the number of frames written.
+        @return the number of frames encoded.
+     */
+    size_t getEncodedCount() const {
+        Lock<Mutex> lock(m_mutex);
+        return m_encodedCount;
+    }
+
+    /**
+        Returns the number of frames dropped because the ring was full or the frame could not be copied.
+        @return the number of frames dropped.
+     */
+    size_t getDroppedCount() const {
+        Lock<Mutex> lock(m_mutex);
+        return m_droppedCount;
+    }
+
+    /**
+        Returns the number of frames that could not be written.
+        @return the number of encoding failures.
+     */
+    size_t getFailedCount() const {
+        Lock<Mutex> lock(m_mutex);
+        return m_failedCount;
+    }
+
+    /**
+        Resets the counters.
+     */
+    void resetCounters() {
+        Lock<Mutex> lock(m_mutex);
+        m_capturedCount = 0;
+        m_encodedCount = 0;
+        m_droppedCount = 0;
+        m_failedCount = 0;
+    }
+
+private:
+    //a ring entry
+    struct Slot {
+        Bitmap bitmap;
+        uint64_t frame;
+        bool queued;
+
+        Slot() : frame(0), queued(false) {
+        }
+    };
+
+    //ring
+    std::vector<Slot> m_slots;
+
+    //settings
+    std::string m_path;
+    std::string m_extension;
+    Format m_format;
+    int m_fps;
+
+    //encoder
+    Thread m_thread;
+    File m_file;
+    bool m_recording;
+
+    //synchronization
+    mutable Mutex m_mutex;
+    Condition m_condition;
+    bool m_stop;
+
+    //capture state
+    std::deque<size_t> m_queue;
+    size_t m_next;
+    uint64_t m_frame;
+    int m_width;
+    int m_height;
+
+    //counters
+    size_t m_capturedCount;
+    size_t m_encodedCount;
+    size_t m_droppedCount;
+    size_t m_failedCount;
+
+    //copies the pixels of a bitmap of the same size
+    static bool _copy(Bitmap &dst, Bitmap &src) {
+        Bitmap::Lock srcLock(src, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        Bitmap::Lock dstLock(dst, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+        const ALLEGRO_LOCKED_REGION *sr = srcLock.getLockedRegion(), *dr = dstLock.getLockedRegion();
+        if (!sr || !dr) return false;
+        for(int y = 0; y < srcLock.getHeight(); ++y) {
+            std::memcpy((uint8_t *)dr->data + y * dr->pitch, (const uint8_t *)sr->data + y * sr->pitch, srcLock.getWidth() * 4);
+        }
+        return true;
+    }
+
+    //writes a frame as an image file
+    bool _writeImage(Slot &slot) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%06llu", (unsigned long long)slot.frame);
+        return slot.bitmap.save((m_path + number + m_extension).c_str());
+    }
+
+    //writes a frame to the Y4M stream, converting it to BT.601 YUV 4:4:4
+    bool _writeY4M(Slot &slot, std::vector<uint8_t> &planes) {
+        Bitmap::Lock lock(slot.bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return false;
+        int width = lock.getWidth(), height = lock.getHeight();
+        size_t size = (size_t)width * height;
+        if (slot.frame == 0) {
+            char header[128];
+            int length = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, m_fps);
+            if (m_file.write(header, length) != (size_t)length) return false;
+        }
+        planes.resize(size * 3);
+        uint8_t *py = &planes[0], *pu = py + size, *pv = pu + size;
+        for(int y = 0; y < height; ++y) {
+            const uint8_t *p = (const uint8_t *)region->data + y * region->pitch;
+            for(int x = 0; x < width; ++x, p += 4) {
+                int r = p[0], g = p[1], b = p[2];
+                *py++ = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                *pu++ = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                *pv++ = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        return m_file.write("FRAME\n", 6) == 6 && m_file.write(&planes[0], planes.size()) == planes.size();
+    }
+
+    //encoder thread loop; it drains the queue before stopping
+    void *_work() {
+        std::vector<uint8_t> planes;
+        for(;;) {
+            size_t index;
+            {
+                Lock<Mutex> lock(m_mutex);
+                while (m_queue.empty() && !m_stop) {
+                    m_condition.wait(m_mutex);
+                }
+                if (m_queue.empty()) break;
+                index = m_queue.front();
+                m_queue.pop_front();
+            }
+
+            Slot &slot = m_slots[index];
+            bool ok = m_format == Y4M ? _writeY4M(slot, planes) : _writeImage(slot);
+
+            Lock<Mutex> lock(m_mutex);
+            slot.queued = false;
+            if (ok) {
+                ++m_encodedCount;
+            }
+            else {
+                ++m_failedCount;
+            }
+        }
+        return nullptr;
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_FRAME_RECORDER_HPP
@@ -0,0 +1,315 @@
+#ifndef ALX_FRAME_STATS_HPP
+#define ALX_FRAME_STATS_HPP
+
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "Display.hpp"
+#include "Event.hpp"
+#include "UserEvent.hpp"
+#include "UserEventSource.hpp"
+
+
+namespace alx {
+
+
+/**
+    Frame timing statistics.
+    Call flip() instead of Display::flip() (or beginFlip() and endFlip() around a custom flip) once per frame.
+    Each frame records three samples, in seconds: the frame time (from the end of the previous flip to the end of this one),
+    the CPU time (from the end of the previous flip to the start of this one) and the flip time.
+    Samples go into a fixed lock-free ring, so percentiles can be queried from any thread;
+    frames whose frame time exceeds the hitch threshold are counted as hitches.
+    Optionally, a SummaryEvent is emitted periodically. When disabled, flip() only flips.
+ */
+class FrameStats : public UserEventSource {
+public:
+    /**
+        Default type of the events emitted.
+     */
+    static const int DefaultEventType = ALLEGRO_GET_EVENT_TYPE('A', 'L', 'X', 'F');
+
+    /**
+        Measured quantity: FrameTime, CpuTime or FlipTime.
+     */
+    enum Metric {
+        FrameTime,
+        CpuTime,
+        FlipTime
+    };
+
+    /**
+        The 50th, 95th and 99th percentiles of a metric, in seconds.
+     */
+    struct Percentiles {
+        //median
+        double p50;
+
+        //95th percentile
+        double p95;
+
+        //99th percentile
+        double p99;
+    };
+
+    /**
+        Statistics of a period.
+     */
+    struct Summary {
+        //percentiles of the samples in the ring, per metric
+        Percentiles percentiles[3];
+
+        //number of frames in the period
+        size_t frameCount;
+
+        //number of hitches in the period
+        size_t hitchCount;
+    };
+
+    /**
+        Event emitted periodically with the statistics of the elapsed period.
+     */
+    class SummaryEvent : public UserEvent {
+    public:
+        /**
+            constructor.
+            @param type event type.
+            @param summary summary.
+         */
+        SummaryEvent(int type, const Summary &summary) : UserEvent(type), m_summary(summary) {
+        }
+
+        /**
+            Returns the summary.
+            @return the summary.
+         */
+        const Summary &getSummary() const {
+            return m_summary;
+        }
+
+    private:
+        Summary m_summary;
+    };
+
+    /**
+        Constructor.
+        @param capacity number of frames kept in the ring; rounded up to a power of two.
+        @param hitchThreshold frame time above which a frame is a hitch, in seconds.
+        @param eventType type of the emitted events.
+     */
+    FrameStats(size_t capacity = 1024, double hitchThreshold = 1.0 / 30, int eventType = DefaultEventType) :
+        m_enabled(true),
+        m_hitchThreshold(hitchThreshold),
+        m_eventType(eventType),
+        m_summaryInterval(0),
+        m_flipStart(0),
+        m_flipEnd(0),
+        m_summaryStart(0),
+        m_summaryFrames(0),
+        m_summaryHitches(0),
+        m_count(0),
+        m_hitchCount(0)
+    {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        m_mask = size - 1;
+        for(std::vector<std::atomic<float>> &samples : m_samples) {
+            samples = std::vector<std::atomic<float>>(size);
+        }
+    }
+
+    /**
+        Checks if recording is enabled.
+        @return true if enabled.
+     */
+    bool isEnabled() const {
+        return m_enabled;
+    }
+
+    /**
+        Enables or disables recording; the next frame after enabling is not recorded.
+        @param enabled true to enable recording.
+     */
+    void setEnabled(bool enabled) {
+        m_enabled = enabled;
+        m_flipEnd = 0;
+    }
+
+    /**
+        Sets the interval of the summary events.
+        @param seconds interval in seconds; 0 disables the events.
+     */
+    void setSummaryInterval(double seconds) {
+        m_summaryInterval = seconds;
+        m_summaryStart = 0;
+    }
+
+    /**
+        Flips the backbuffer of the current display and records the frame.
+     */
+    void flip() {
+        if (!m_enabled) {
+            Display::flip();
+            return;
+        }
+        beginFlip();
+        Display::flip();
+        endFlip();
+    }
+
+    /**
+        Marks the start of a flip.
+     */
+    void beginFlip() {
+        m_flipStart = al_get_time();
+    }
+
+    /**
+        Marks the end of a flip and records the frame.
+     */
+    void endFlip() {
+        double now = al_get_time();
+        double last = m_flipEnd;
+        m_flipEnd = now;
+        if (!m_enabled || last == 0) {
+            m_summaryStart = now;
+            return;
+        }
+
+        float frame = (float)(now - last);
+        size_t i = m_count.load(std::memory_order_relaxed);
+        m_samples[FrameTime][i & m_mask].store(frame, std::memory_order_relaxed);
+        m_samples[CpuTime][i & m_mask].store((float)(m_flipStart - last), std::memory_order_relaxed);
+        m_samples[FlipTime][i & m_mask].store((float)(now - m_flipStart), std::memory_order_relaxed);
+        m_count.store(i + 1, std::memory_order_release);
+
+        ++m_summaryFrames;
+        if (frame > m_hitchThreshold) {
+            m_hitchCount.fetch_add(1, std::memory_order_relaxed);
+            ++m_summaryHitches;
+        }
+
+        if (m_summaryInterval > 0 && now - m_summaryStart >= m_summaryInterval) {
+            Summary summary = getSummary();
+            summary.frameCount = m_summaryFrames;
+            summary.hitchCount = m_summaryHitches;
+            emitUserEvent(new SummaryEvent(m_eventType, summary));
+            m_summaryStart = now;
+            m_summaryFrames = 0;
+            m_summaryHitches = 0;
+        }
+    }
+
+    /**
+        Returns the number of frames recorded.
+        @return the number of frames recorded.
+     */
+    size_t getFrameCount() const {
+        return m_count.load(std::memory_order_acquire);
+    }
+
+    /**
+        Returns the number of hitches recorded.
+        @return the number of hitches recorded.
+     */
+    size_t getHitchCount() const {
+        return m_hitchCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+        Returns a percentile of a metric over the frames in the ring.
+        @param metric metric.
+        @param p percentile, from 0 to 100.
+        @return the percentile in seconds; 0 if no frames were recorded.
+     */
+    double getPercentile(Metric metric, double p) const {
+        std::vector<float> samples = _copy(metric);
+        return _percentile(samples, p);
+    }
+
+    /**
+        Returns the 50th, 95th and 99th percentiles of a metric over the frames in the ring.
+        @param metric metric.
+        @return the percentiles in seconds; 0 if no frames were recorded.
+     */
+    Percentiles getPercentiles(Metric metric) const {
+        std::vector<float> samples = _copy(metric);
+        Percentiles result;
+        result.p50 = _percentile(samples, 50);
+        result.p95 = _percentile(samples, 95);
+        result.p99 = _percentile(samples, 99);
+        return result;
+    }
+
+    /**
+        Returns the percentiles of all metrics over the frames in the ring, and the total frame and hitch counts.
+        @return the summary.
+     */
+    Summary getSummary() const {
+        Summary result;
+        for(int metric = FrameTime; metric <= FlipTime; ++metric) {
+            result.percentiles[metric] = getPercentiles((Metric)metric);
+        }
+        result.frameCount = getFrameCount();
+        result.hitchCount = getHitchCount();
+        return result;
+    }
+
+    /**
+        Discards all recorded frames; must be called from the thread that flips.
+     */
+    void reset() {
+        m_count.store(0, std::memory_order_release);
+        m_hitchCount.store(0, std::memory_order_relaxed);
+        m_flipEnd = 0;
+        m_summaryFrames = 0;
+        m_summaryHitches = 0;
+    }
+
+private:
+    //settings
+    bool m_enabled;
+    double m_hitchThreshold;
+    int m_eventType;
+    double m_summaryInterval;
+
+    //state of the flipping thread
+    double m_flipStart;
+    double m_flipEnd;
+    double m_summaryStart;
+    size_t m_summaryFrames;
+    size_t m_summaryHitches;
+
+    //ring, one array per metric; written by the flipping thread only
+    std::vector<std::atomic<float>> m_samples[3];
+    size_t m_mask;
+    std::atomic<size_t> m_count;
+    std::atomic<size_t> m_hitchCount;
+
+    //copies the samples of a metric in the ring
+    std::vector<float> _copy(Metric metric) const {
+        size_t count = std::min(m_count.load(std::memory_order_acquire), m_mask + 1);
+        std::vector<float> result(count);
+        for(size_t i = 0; i < count; ++i) {
+            result[i] = m_samples[metric][i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    //returns a percentile of samples, using the nearest rank; reorders the samples
+    static double _percentile(std::vector<float> &samples, double p) {
+        if (samples.empty()) return 0;
+        size_t rank = (size_t)std::ceil(p / 100 * samples.size());
+        size_t index = std::min(rank > 0 ? rank - 1 : 0, samples.size() - 1);
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_FRAME_STATS_HPP
@@ -0,0 +1,225 @@
+#ifndef ALX_HEADLESS_DISPLAY_HPP
+#define ALX_HEADLESS_DISPLAY_HPP
+
+
+#include <cstdlib>
+#include <cstdint>
+#include "Bitmap.hpp"
+#include "Size.hpp"
+#include "State.hpp"
+#include "Event.hpp"
+#include "UserEventSource.hpp"
+
+
+namespace alx {
+
+
+/**
+    A display replacement for machines without a GPU or window system, e.g. for benchmarks and CI.
+    It offers the parts of the Display API used by render loops, backed by a memory bitmap as the backbuffer;
+    like a display, it becomes the target on construction, so code that draws to the target bitmap runs unmodified
+    (with Allegro's software renderer). The event source never emits events by itself, but tests can inject
+    user events through it. The backbuffer keeps its content after flip(), so frames can be captured for comparison.
+    Bitmaps created while no display exists are memory bitmaps, which the software renderer can draw.
+ */
+class HeadlessDisplay : public UserEventSource {
+public:
+    /**
+        Constructor.
+        Creates the backbuffer and makes it the target bitmap.
+        @param width width of the backbuffer.
+        @param height height of the backbuffer.
+        @param format pixel format of the backbuffer.
+     */
+    HeadlessDisplay(int width, int height, int format = ALLEGRO_PIXEL_FORMAT_ANY_32_WITH_ALPHA) :
+        m_format(format),
+        m_frameCount(0)
+    {
+        _create(width, height);
+        setTarget(*this);
+    }
+
+    /**
+        Checks if the backbuffer was created.
+        @return true if the backbuffer exists.
+     */
+    explicit operator bool() const {
+        return (bool)m_backbuffer;
+    }
+
+    /**
+        Returns the backbuffer.
+        @return the backbuffer.
+     */
+    Bitmap getBackbuffer() const {
+        return m_backbuffer;
+    }
+
+    /**
+        Returns the flags of the backbuffer.
+        @return the flags of the backbuffer.
+     */
+    int getFlags() const {
+        return m_backbuffer.getFlags();
+    }
+
+    /**
+        Returns the pixel format of the backbuffer.
+        @return the pixel format of the backbuffer.
+     */
+    int getFormat() const {
+        return m_backbuffer.getFormat();
+    }
+
+    /**
+        Returns the width.
+        @return the width.
+     */
+    int getWidth() const {
+        return m_backbuffer.getWidth();
+    }
+
+    /**
+        Returns the height.
+        @return the height.
+     */
+    int getHeight() const {
+        return m_backbuffer.getHeight();
+    }
+
+    /**
+        Returns the size.
+        @return the size.
+     */
+    Size<int> getSize() const {
+        return Size<int>(getWidth(), getHeight());
+    }
+
+    /**
+        Resizes the backbuffer; its content is cleared. If the backbuffer was the target bitmap, the new one becomes the target.
+        @param width new width.
+        @param height new height.
+        @return true on success.
+     */
+    bool setSize(int width, int height) {
+        bool target = m_backbuffer && al_get_target_bitmap() == m_backbuffer.get();
+        _create(width, height);
+        if (target) setTarget(*this);
+        return (bool)m_backbuffer;
+    }
+
+    /**
+        Resizes the backbuffer; its content is cleared. If the backbuffer was the target bitmap, the new one becomes the target.
+        @param size new size.
+        @return true on success.
+     */
+    bool setSize(const Size<int> &size) {
+        return setSize(size.getWidth(), size.getHeight());
+    }
+
+    /**
+        Ends a frame; the backbuffer keeps its content.
+     */
+    void flip() {
+        ++m_frameCount;
+    }
+
+    /**
+        Returns the number of frames flipped.
+        @return the number of frames flipped.
+     */
+    uint64_t getFrameCount() const {
+        return m_frameCount;
+    }
+
+    /**
+        Returns a memory copy of the backbuffer.
+        @return a copy of the backbuffer.
+     */
+    Bitmap captureFrame() const {
+        State state;
+        state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+        Bitmap result = m_backbuffer.clone();
+        state.restore();
+        return result;
+    }
+
+    /**
+        Saves the backbuffer to a file; requires the image addon.
+        @param filename filename.
+        @return true on success.
+     */
+    bool saveFrame(const char *filename) const {
+        return m_backbuffer.save(filename);
+    }
+
+    /**
+        Sets the target bitmap to be the backbuffer of the given headless display.
+        @param display headless display.
+     */
+    static void setTarget(HeadlessDisplay &display) {
+        al_set_target_bitmap(display.m_backbuffer.get());
+    }
+
+    /**
+        Counts the pixels of two bitmaps that differ, for comparing rendered frames against reference images.
+        @param a first bitmap.
+        @param b second bitmap.
+        @param tolerance largest difference allowed per color component for pixels to be considered equal.
+        @return the number of differing pixels; SIZE_MAX if the bitmaps differ in size or could not be locked.
+     */
+    static size_t countDifferences(Bitmap &a, Bitmap &b, int tolerance = 0) {
+        if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return SIZE_MAX;
+        Bitmap::Lock lockA(a, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        Bitmap::Lock lockB(b, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *ra = lockA.getLockedRegion(), *rb = lockB.getLockedRegion();
+        if (!ra || !rb) return SIZE_MAX;
+        size_t count = 0;
+        for(int y = 0; y < lockA.getHeight(); ++y) {
+            const uint8_t *pa = (const uint8_t *)ra->data + y * ra->pitch;
+            const uint8_t *pb = (const uint8_t *)rb->data + y * rb->pitch;
+            for(int x = 0; x < lockA.getWidth() * 4; x += 4) {
+                for(int c = 0; c < 4; ++c) {
+                    if (std::abs(pa[x + c] - pb[x + c]) > tolerance) {
+                        ++count;
+                        break;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+private:
+    //pixel format
+    int m_format;
+
+    //backbuffer
+    Bitmap m_backbuffer;
+
+    //frames flipped
+    uint64_t m_frameCount;
+
+    //creates the backbuffer as a memory bitmap, cleared to black
+    void _create(int width, int height) {
+        //keep the old backbuffer alive until the state, which may point to it, is restored
+        Bitmap old = m_backbuffer;
+        State state;
+        state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS | ALLEGRO_STATE_TARGET_BITMAP);
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+        al_set_new_bitmap_format(m_format);
+        m_backbuffer = Bitmap(width, height);
+        if (m_backbuffer) {
+            al_set_target_bitmap(m_backbuffer.get());
+            al_clear_to_color(al_map_rgb(0, 0, 0));
+        }
+        state.restore();
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_HEADLESS_DISPLAY_HPP
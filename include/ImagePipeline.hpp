@@ -0,0 +1,443 @@
+#ifndef ALX_IMAGE_PIPELINE_HPP
+#define ALX_IMAGE_PIPELINE_HPP
+
+
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include "Bitmap.hpp"
+#include "Rect.hpp"
+#include "WorkerPool.hpp"
+
+
+namespace alx {
+
+
+/**
+    Runs a chain of image processing stages over a bitmap, in parallel.
+    The bitmap is locked in ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE (bytes R, G, B, A in memory),
+    split into rectangular tiles, and the tiles are processed by a pool of worker threads plus the calling thread.
+    Stages that read neighbouring pixels declare a halo; they read from a full copy of the previous result,
+    with coordinates clamped to the image, so tiles never see partially processed neighbours.
+    Point stages (no halo) that follow a stage are run on the same tile in place, while it is still in the cache.
+    It is meant for memory bitmaps; video bitmaps work too, at the cost of the lock.
+ */
+class ImagePipeline {
+public:
+    /**
+        An RGBA image buffer with 4 bytes per pixel.
+     */
+    struct Image {
+        //first row
+        uint8_t *data;
+
+        //width in pixels
+        int width;
+
+        //height in pixels
+        int height;
+
+        //distance between rows, in bytes
+        int pitch;
+
+        /**
+            Returns a row.
+            @param y row index.
+            @return pointer to the first byte of the row.
+         */
+        uint8_t *getRow(int y) const {
+            return data + y * pitch;
+        }
+
+        /**
+            Returns a pixel, with the coordinates clamped to the image.
+            @param x x coordinate.
+            @param y y coordinate.
+            @return pointer to the 4 bytes of the pixel.
+         */
+        const uint8_t *getClamped(int x, int y) const {
+            x = std::max(0, std::min(x, width - 1));
+            y = std::max(0, std::min(y, height - 1));
+            return data + y * pitch + x * 4;
+        }
+    };
+
+    /**
+        Base class for stages.
+     */
+    class Stage {
+    public:
+        /**
+            Destructor.
+         */
+        virtual ~Stage() {
+        }
+
+        /**
+            Returns how many pixels around a tile the stage reads.
+            Stages with a halo of 0 are point stages and are run in place (src and dst are the same image).
+            @return the halo size.
+         */
+        virtual int getHalo() const {
+            return 0;
+        }
+
+        /**
+            Processes a tile; called concurrently for different tiles.
+            @param src source image; the whole image can be read.
+            @param dst destination image; only the tile may be written.
+            @param tile tile.
+         */
+        virtual void process(const Image &src, const Image &dst, const Rect<int> &tile) const = 0;
+    };
+
+    /**
+        Horizontal box blur pass.
+     */
+    class HorizontalBlur : public Stage {
+    public:
+        /**
+            Constructor.
+            @param radius blur radius.
+         */
+        HorizontalBlur(int radius) : m_radius(radius) {
+        }
+
+        int getHalo() const {
+            return m_radius;
+        }
+
+        void process(const Image &src, const Image &dst, const Rect<int> &tile) const {
+            int n = m_radius * 2 + 1;
+            for(int y = tile.getTop(); y <= tile.getBottom(); ++y) {
+                int sum[4] = {0, 0, 0, 0};
+                for(int x = tile.getLeft() - m_radius; x <= tile.getLeft() + m_radius; ++x) {
+                    const uint8_t *p = src.getClamped(x, y);
+                    for(int c = 0; c < 4; ++c) sum[c] += p[c];
+                }
+                uint8_t *out = dst.getRow(y) + tile.getLeft() * 4;
+                for(int x = tile.getLeft(); x <= tile.getRight(); ++x, out += 4) {
+                    for(int c = 0; c < 4; ++c) out[c] = (uint8_t)((sum[c] + n / 2) / n);
+                    const uint8_t *add = src.getClamped(x + m_radius + 1, y), *sub = src.getClamped(x - m_radius, y);
+                    for(int c = 0; c < 4; ++c) sum[c] += add[c] - sub[c];
+                }
+            }
+        }
+
+    private:
+        int m_radius;
+    };
+
+    /**
+        Vertical box blur pass.
+     */
+    class VerticalBlur : public Stage {
+    public:
+        /**
+            Constructor.
+            @param radius blur radius.
+         */
+        VerticalBlur(int radius) : m_radius(radius) {
+        }
+
+        int getHalo() const {
+            return m_radius;
+        }
+
+        void process(const Image &src, const Image &dst, const Rect<int> &tile) const {
+            int n = m_radius * 2 + 1;
+            int left = tile.getLeft(), bytes = tile.getWidth() * 4;
+            std::vector<int> sum(bytes, 0);
+            for(int y = tile.getTop() - m_radius; y <= tile.getTop() + m_radius; ++y) {
+                const uint8_t *row = src.getClamped(left, y);
+                for(int i = 0; i < bytes; ++i) sum[i] += row[i];
+            }
+            for(int y = tile.getTop(); y <= tile.getBottom(); ++y) {
+                uint8_t *out = dst.getRow(y) + left * 4;
+                for(int i = 0; i < bytes; ++i) out[i] = (uint8_t)((sum[i] + n / 2) / n);
+                const uint8_t *add = src.getClamped(left, y + m_radius + 1), *sub = src.getClamped(left, y - m_radius);
+                for(int i = 0; i < bytes; ++i) sum[i] += add[i] - sub[i];
+            }
+        }
+
+    private:
+        int m_radius;
+    };
+
+    /**
+        3x3 convolution of the color components; alpha is kept.
+     */
+    class Convolution : public Stage {
+    public:
+        /**
+            Constructor.
+            @param kernel 3x3 kernel, in row order.
+         */
+        Convolution(const float kernel[9]) {
+            std::copy(kernel, kernel + 9, m_kernel);
+        }
+
+        int getHalo() const {
+            return 1;
+        }
+
+        void process(const Image &src, const Image &dst, const Rect<int> &tile) const {
+            for(int y = tile.getTop(); y <= tile.getBottom(); ++y) {
+                uint8_t *out = dst.getRow(y) + tile.getLeft() * 4;
+                for(int x = tile.getLeft(); x <= tile.getRight(); ++x, out += 4) {
+                    float sum[3] = {0, 0, 0};
+                    for(int k = 0; k < 9; ++k) {
+                        const uint8_t *p = src.getClamped(x + k % 3 - 1, y + k / 3 - 1);
+                        for(int c = 0; c < 3; ++c) sum[c] += p[c] * m_kernel[k];
+                    }
+                    for(int c = 0; c < 3; ++c) out[c] = (uint8_t)std::max(0.0f, std::min(sum[c] + 0.5f, 255.0f));
+                    out[3] = src.getClamped(x, y)[3];
+                }
+            }
+        }
+
+    private:
+        float m_kernel[9];
+    };
+
+    /**
+        Draws an outline around opaque areas: transparent pixels next to opaque ones take the outline color.
+     */
+    class Outline : public Stage {
+    public:
+        /**
+            Constructor.
+            @param color outline color.
+            @param threshold alpha at or above which a pixel counts as opaque.
+         */
+        Outline(const ALLEGRO_COLOR &color, int threshold = 128) : m_threshold(threshold) {
+            al_unmap_rgba(color, &m_color[0], &m_color[1], &m_color[2], &m_color[3]);
+        }
+
+        int getHalo() const {
+            return 1;
+        }
+
+        void process(const Image &src, const Image &dst, const Rect<int> &tile) const {
+            for(int y = tile.getTop(); y <= tile.getBottom(); ++y) {
+                uint8_t *out = dst.getRow(y) + tile.getLeft() * 4;
+                for(int x = tile.getLeft(); x <= tile.getRight(); ++x, out += 4) {
+                    const uint8_t *p = src.getClamped(x, y);
+                    bool edge = false;
+                    if (p[3] < m_threshold) {
+                        for(int k = 0; k < 9 && !edge; ++k) {
+                            edge = src.getClamped(x + k % 3 - 1, y + k / 3 - 1)[3] >= m_threshold;
+                        }
+                    }
+                    std::memcpy(out, edge ? m_color : p, 4);
+                }
+            }
+        }
+
+    private:
+        unsigned char m_color[4];
+        int m_threshold;
+    };
+
+    /**
+        Color grading with a 3x4 matrix over the color components: out = M * (r, g, b, 1); alpha is kept.
+        Components are in the range 0 to 1.
+     */
+    class ColorGrade : public Stage {
+    public:
+        /**
+            Constructor.
+            @param matrix 3 rows of 4 values; the 4th column is the offset.
+         */
+        ColorGrade(const float matrix[12]) {
+            //precompute per-channel contributions so that the inner loop is lookups and adds
+            for(int row = 0; row < 3; ++row) {
+                for(int col = 0; col < 3; ++col) {
+                    for(int v = 0; v < 256; ++v) {
+                        m_table[row][col][v] = matrix[row * 4 + col] * v + (col == 0 ? matrix[row * 4 + 3] * 255.0f : 0.0f);
+                    }
+                }
+            }
+        }
+
+        void process(const Image &, const Image &dst, const Rect<int> &tile) const {
+            for(int y = tile.getTop(); y <= tile.getBottom(); ++y) {
+                uint8_t *p = dst.getRow(y) + tile.getLeft() * 4;
+                for(int x = tile.getLeft(); x <= tile.getRight(); ++x, p += 4) {
+                    uint8_t r = p[0], g = p[1], b = p[2];
+                    for(int c = 0; c < 3; ++c) {
+                        float v = m_table[c][0][r] + m_table[c][1][g] + m_table[c][2][b];
+                        p[c] = (uint8_t)std::max(0.0f, std::min(v + 0.5f, 255.0f));
+                    }
+                }
+            }
+        }
+
+    private:
+        float m_table[3][3][256];
+    };
+
+    /**
+        Constructor.
+        Starts the worker threads.
+        @param threadCount total number of threads, including the calling thread; 1 runs everything on the calling thread.
+        @param tileSize width and height of the tiles.
+     */
+    ImagePipeline(int threadCount = 4, int tileSize = 128) :
+        m_tileSize(std::max(tileSize, 1)),
+        m_pool(threadCount)
+    {
+    }
+
+    /**
+        Returns the number of threads, including the calling thread.
+        @return the number of threads.
+     */
+    int getThreadCount() const {
+        return m_pool.getThreadCount();
+    }
+
+    /**
+        Appends a stage.
+        @param stage stage.
+        @return reference to this.
+     */
+    ImagePipeline &add(const std::shared_ptr<Stage> &stage) {
+        m_stages.push_back(stage);
+        return *this;
+    }
+
+    /**
+        Appends a box blur, as a horizontal and a vertical pass.
+        @param radius blur radius.
+        @return reference to this.
+     */
+    ImagePipeline &addBlur(int radius) {
+        add(std::make_shared<HorizontalBlur>(radius));
+        return add(std::make_shared<VerticalBlur>(radius));
+    }
+
+    /**
+        Appends a sharpen filter.
+        @param amount strength; 0 leaves the image unchanged.
+        @return reference to this.
+     */
+    ImagePipeline &addSharpen(float amount) {
+        const float kernel[9] = {0, -amount, 0, -amount, 1 + 4 * amount, -amount, 0, -amount, 0};
+        return add(std::make_shared<Convolution>(kernel));
+    }
+
+    /**
+        Appends an outline.
+        @param color outline color.
+        @param threshold alpha at or above which a pixel counts as opaque.
+        @return reference to this.
+     */
+    ImagePipeline &addOutline(const ALLEGRO_COLOR &color, int threshold = 128) {
+        return add(std::make_shared<Outline>(color, threshold));
+    }
+
+    /**
+        Appends a color grade.
+        @param matrix 3 rows of 4 values; the 4th column is the offset.
+        @return reference to this.
+     */
+    ImagePipeline &addColorGrade(const float matrix[12]) {
+        return add(std::make_shared<ColorGrade>(matrix));
+    }
+
+    /**
+        Removes all stages.
+     */
+    void clear() {
+        m_stages.clear();
+    }
+
+    /**
+        Runs the stages over the whole bitmap.
+        @param bitmap bitmap to process in place.
+        @return true on success, false if the bitmap could not be locked.
+     */
+    bool run(Bitmap &bitmap) {
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READWRITE);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return false;
+        Image image = {static_cast<uint8_t *>(region->data), lock.getWidth(), lock.getHeight(), region->pitch};
+        run(image);
+        return true;
+    }
+
+    /**
+        Runs the stages over an image buffer.
+        @param image image to process in place.
+     */
+    void run(const Image &image) {
+        if (image.width <= 0 || image.height <= 0) return;
+
+        //tiles
+        m_tiles.clear();
+        for(int y = 0; y < image.height; y += m_tileSize) {
+            for(int x = 0; x < image.width; x += m_tileSize) {
+                m_tiles.push_back(Rect<int>(Point<int>(x, y), Size<int>(std::min(m_tileSize, image.width - x), std::min(m_tileSize, image.height - y))));
+            }
+        }
+
+        //scratch buffer for stages with a halo
+        std::vector<uint8_t> scratch;
+        Image buffers[2] = {image, image};
+        int current = 0;
+
+        for(size_t begin = 0; begin < m_stages.size(); ) {
+            //a group is one stage followed by the point stages after it
+            size_t end = begin + 1;
+            while (end < m_stages.size() && m_stages[end]->getHalo() == 0) ++end;
+
+            Image src = buffers[current], dst = src;
+            if (m_stages[begin]->getHalo() > 0) {
+                if (scratch.empty()) {
+                    scratch.resize((size_t)image.width * image.height * 4);
+                    Image s = {scratch.data(), image.width, image.height, image.width * 4};
+                    buffers[1] = s;
+                }
+                current = 1 - current;
+                dst = buffers[current];
+            }
+
+            const std::vector<std::shared_ptr<Stage>> &stages = m_stages;
+            const std::vector<Rect<int>> &tiles = m_tiles;
+            m_pool.run((int)tiles.size(), [&stages, &tiles, begin, end, src, dst](int index) {
+                const Rect<int> &tile = tiles[index];
+                stages[begin]->process(src, dst, tile);
+                for(size_t i = begin + 1; i < end; ++i) {
+                    stages[i]->process(dst, dst, tile);
+                }
+            });
+            begin = end;
+        }
+
+        //copy the result back
+        if (current == 1) {
+            for(int y = 0; y < image.height; ++y) {
+                std::memcpy(image.getRow(y), buffers[1].getRow(y), image.width * 4);
+            }
+        }
+    }
+
+private:
+    //parameters
+    int m_tileSize;
+    std::vector<std::shared_ptr<Stage>> m_stages;
+
+    //workers
+    WorkerPool m_pool;
+
+    //tiles of the current image
+    std::vector<Rect<int>> m_tiles;
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_IMAGE_PIPELINE_HPP
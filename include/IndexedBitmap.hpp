@@ -0,0 +1,485 @@
+#ifndef ALX_INDEXED_BITMAP_HPP
+#define ALX_INDEXED_BITMAP_HPP
+
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include "Cpu.hpp"
+#include "Bitmap.hpp"
+#include "Color.hpp"
+
+
+namespace alx {
+
+
+/**
+    A palette-indexed image: 8-bit pixel indices into a palette of 256 colors.
+    The indices take a quarter of the memory of 32-bit pixels. The image is expanded into a bitmap
+    only when it is requested after its pixels or palette change; changing pixels re-expands only
+    the modified rows, while changing the palette (e.g. for color cycling) re-expands the whole image.
+    The bitmap is created with the current new bitmap flags and locked in ARGB_8888 format.
+ */
+class IndexedBitmap {
+public:
+    /**
+        Number of palette entries.
+     */
+    static const int PaletteSize = 256;
+
+    /**
+        Constructor.
+        All pixels are set to index 0, and all palette entries to transparent black.
+        @param width width of the image in pixels.
+        @param height height of the image in pixels.
+     */
+    IndexedBitmap(int width = 0, int height = 0) :
+        m_palette(PaletteSize, 0),
+        m_expandedRowCount(0)
+    {
+        create(width, height);
+    }
+
+    /**
+        The copy constructor.
+        The copy gets its own bitmap, expanded when first requested; the bitmap is not shared,
+        since both images would otherwise expand their pixels into it.
+        @param src source image.
+     */
+    IndexedBitmap(const IndexedBitmap &src) :
+        m_width(src.m_width),
+        m_height(src.m_height),
+        m_pixels(src.m_pixels),
+        m_palette(src.m_palette),
+        m_dirtyRows(src.m_height, 1),
+        m_expandedRowCount(0)
+    {
+    }
+
+    /**
+        The copy assignment operator.
+        The bitmap is released and recreated when next requested, as in the copy constructor.
+        @param src source image.
+        @return reference to this.
+     */
+    IndexedBitmap &operator = (const IndexedBitmap &src) {
+        if (this == &src) return *this;
+        m_width = src.m_width;
+        m_height = src.m_height;
+        m_pixels = src.m_pixels;
+        m_palette = src.m_palette;
+        m_dirtyRows.assign(m_height, 1);
+        m_bitmap.reset();
+        return *this;
+    }
+
+    /**
+        Resizes the image; all pixels are set to index 0 and the bitmap is released.
+        The palette is kept.
+        @param width width of the image in pixels.
+        @param height height of the image in pixels.
+     */
+    void create(int width, int height) {
+        m_width = std::max(width, 0);
+        m_height = std::max(height, 0);
+        m_pixels.assign((size_t)m_width * m_height, 0);
+        m_dirtyRows.assign(m_height, 1);
+        m_bitmap.reset();
+    }
+
+    /**
+        Creates the image from a bitmap, computing a palette of at most the given number of colors with median cut.
+        Bitmaps with fewer distinct colors than the limit are converted exactly.
+        Unused palette entries are set to transparent black.
+        @param bitmap source bitmap.
+        @param maxColors maximum number of palette colors, from 1 to 256.
+        @return true on success, false if the bitmap could not be locked.
+     */
+    bool quantize(Bitmap &bitmap, int maxColors = PaletteSize) {
+        maxColors = maxColors < 1 ? 1 : maxColors > PaletteSize ? PaletteSize : maxColors;
+
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return false;
+
+        //histogram of distinct colors
+        std::unordered_map<uint32_t, uint32_t> histogram;
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            const uint32_t *row = _row(region, y);
+            for(int x = 0; x < lock.getWidth(); ++x) {
+                ++histogram[row[x]];
+            }
+        }
+        std::vector<_Entry> entries;
+        entries.reserve(histogram.size());
+        for(const std::pair<const uint32_t, uint32_t> &h : histogram) {
+            _Entry entry = {h.first, h.second};
+            entries.push_back(entry);
+        }
+
+        //split the colors into boxes, one per palette entry; each color maps to the entry of its box
+        std::vector<_Box> boxes = _medianCut(entries, maxColors);
+        std::fill(m_palette.begin(), m_palette.end(), 0);
+        for(size_t i = 0; i < boxes.size(); ++i) {
+            m_palette[i] = _average(entries, boxes[i]);
+            for(size_t j = boxes[i].begin; j < boxes[i].end; ++j) {
+                histogram[entries[j].color] = (uint32_t)i;
+            }
+        }
+
+        create(lock.getWidth(), lock.getHeight());
+        for(int y = 0; y < m_height; ++y) {
+            const uint32_t *row = _row(region, y);
+            uint8_t *dst = &m_pixels[(size_t)y * m_width];
+            uint32_t lastColor = 0;
+            uint8_t lastIndex = 0;
+            for(int x = 0; x < m_width; ++x) {
+                if (x == 0 || row[x] != lastColor) {
+                    lastColor = row[x];
+                    lastIndex = (uint8_t)histogram[lastColor];
+                }
+                dst[x] = lastIndex;
+            }
+        }
+        return true;
+    }
+
+    /**
+        Returns the width of the image.
+        @return the width of the image in pixels.
+     */
+    int getWidth() const {
+        return m_width;
+    }
+
+    /**
+        Returns the height of the image.
+        @return the height of the image in pixels.
+     */
+    int getHeight() const {
+        return m_height;
+    }
+
+    /**
+        Returns a pixel's palette index.
+        @param x horizontal coordinate.
+        @param y vertical coordinate.
+        @return the palette index.
+     */
+    uint8_t getPixel(int x, int y) const {
+        return m_pixels[(size_t)y * m_width + x];
+    }
+
+    /**
+        Sets a pixel's palette index; the pixel's row is re-expanded when the bitmap is next requested.
+        @param x horizontal coordinate.
+        @param y vertical coordinate.
+        @param index palette index.
+     */
+    void setPixel(int x, int y, uint8_t index) {
+        uint8_t &pixel = m_pixels[(size_t)y * m_width + x];
+        if (pixel == index) return;
+        pixel = index;
+        m_dirtyRows[y] = 1;
+    }
+
+    /**
+        Returns a row of palette indices for reading.
+        @param y row.
+        @return pointer to the row's indices.
+     */
+    const uint8_t *getRow(int y) const {
+        return &m_pixels[(size_t)y * m_width];
+    }
+
+    /**
+        Returns a row of palette indices for writing; the row is re-expanded when the bitmap is next requested.
+        @param y row.
+        @return pointer to the row's indices.
+     */
+    uint8_t *modifyRow(int y) {
+        m_dirtyRows[y] = 1;
+        return &m_pixels[(size_t)y * m_width];
+    }
+
+    /**
+        Returns a palette color.
+        @param index palette index.
+        @return the color.
+     */
+    Color getColor(uint8_t index) const {
+        return Color(m_palette[index]);
+    }
+
+    /**
+        Sets a palette color; the whole image is re-expanded when the bitmap is next requested.
+        @param index palette index.
+        @param color color.
+     */
+    void setColor(uint8_t index, const Color &color) {
+        if (m_palette[index] == (uint32_t)color) return;
+        m_palette[index] = color;
+        invalidate();
+    }
+
+    /**
+        Sets palette colors; the whole image is re-expanded when the bitmap is next requested.
+        @param colors colors.
+        @param count number of colors; at most 256 - first.
+        @param first index of the first palette entry to set.
+     */
+    void setPalette(const Color *colors, int count, int first = 0) {
+        for(int i = 0; i < count; ++i) {
+            m_palette[first + i] = colors[i];
+        }
+        invalidate();
+    }
+
+    /**
+        Rotates a range of palette entries, for color cycling.
+        @param first index of the first palette entry of the range.
+        @param count number of palette entries in the range.
+        @param steps number of entries to rotate by; positive values move colors to higher indices.
+     */
+    void rotatePalette(int first, int count, int steps = 1) {
+        if (count <= 1) return;
+        steps %= count;
+        if (steps < 0) steps += count;
+        std::vector<uint32_t>::iterator begin = m_palette.begin() + first;
+        std::rotate(begin, begin + (count - steps), begin + count);
+        invalidate();
+    }
+
+    /**
+        Marks the whole image for re-expansion.
+     */
+    void invalidate() {
+        std::fill(m_dirtyRows.begin(), m_dirtyRows.end(), 1);
+    }
+
+    /**
+        Marks rows for re-expansion.
+        @param y first row.
+        @param count number of rows.
+     */
+    void invalidateRows(int y, int count) {
+        int end = std::min(y + count, m_height);
+        for(y = std::max(y, 0); y < end; ++y) {
+            m_dirtyRows[y] = 1;
+        }
+    }
+
+    /**
+        Expands the modified rows into the bitmap, creating the bitmap if needed.
+        @return true on success; false if the image is empty or the bitmap could not be created or locked.
+     */
+    bool update() {
+        if (m_width == 0 || m_height == 0) return false;
+        if (!m_bitmap) {
+            m_bitmap = Bitmap(m_width, m_height);
+            if (!m_bitmap) return false;
+            invalidate();
+        }
+
+        std::vector<uint8_t>::const_iterator first = std::find(m_dirtyRows.begin(), m_dirtyRows.end(), 1);
+        if (first == m_dirtyRows.end()) return true;
+        int top = (int)(first - m_dirtyRows.begin());
+        int bottom = m_height - 1;
+        while (!m_dirtyRows[bottom]) --bottom;
+
+        //lock only the span of dirty rows; clean rows within it are skipped
+        Bitmap::Lock lock(m_bitmap, 0, top, m_width, bottom - top + 1, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_READWRITE);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return false;
+        for(int y = top; y <= bottom; ++y) {
+            if (!m_dirtyRows[y]) continue;
+            expandRow(_row(region, y - top), getRow(y), m_width, &m_palette[0]);
+            m_dirtyRows[y] = 0;
+            ++m_expandedRowCount;
+        }
+        return true;
+    }
+
+    /**
+        Returns the expanded bitmap, updating it first.
+        @return the bitmap; null if the image is empty or the bitmap could not be created.
+     */
+    const Bitmap &getBitmap() {
+        update();
+        return m_bitmap;
+    }
+
+    /**
+        Releases the bitmap, e.g. before the display is destroyed; it is recreated when next requested.
+     */
+    void release() {
+        m_bitmap.reset();
+    }
+
+    /**
+        Returns the number of rows expanded so far.
+        @return the number of rows expanded.
+     */
+    size_t getExpandedRowCount() const {
+        return m_expandedRowCount;
+    }
+
+    /**
+        Resets the expanded row counter.
+     */
+    void resetCounters() {
+        m_expandedRowCount = 0;
+    }
+
+    /**
+        Expands a row of palette indices into 32-bit pixels.
+        @param dst destination pixels.
+        @param src palette indices.
+        @param n number of pixels.
+        @param palette 256-entry palette.
+     */
+    static void expandRow(uint32_t *dst, const uint8_t *src, int n, const uint32_t *palette) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _expandAVX2(dst, src, n, palette);
+#endif
+        for(; i + 4 <= n; i += 4) {
+            dst[i    ] = palette[src[i    ]];
+            dst[i + 1] = palette[src[i + 1]];
+            dst[i + 2] = palette[src[i + 2]];
+            dst[i + 3] = palette[src[i + 3]];
+        }
+        for(; i < n; ++i) {
+            dst[i] = palette[src[i]];
+        }
+    }
+
+private:
+    //a distinct color of a quantized bitmap
+    struct _Entry {
+        uint32_t color;
+        uint32_t count;
+    };
+
+    //a range of entries during median cut
+    struct _Box {
+        size_t begin;
+        size_t end;
+    };
+
+    //size
+    int m_width;
+    int m_height;
+
+    //indices
+    std::vector<uint8_t> m_pixels;
+
+    //palette, as 0xAARRGGBB values
+    std::vector<uint32_t> m_palette;
+
+    //rows to re-expand
+    std::vector<uint8_t> m_dirtyRows;
+
+    //expanded bitmap
+    Bitmap m_bitmap;
+
+    //counters
+    size_t m_expandedRowCount;
+
+    //returns a row of a locked 32-bit region
+    static uint32_t *_row(const ALLEGRO_LOCKED_REGION *region, int y) {
+        return (uint32_t *)((uint8_t *)region->data + y * region->pitch);
+    }
+
+    //returns the range of a color channel within a box
+    static int _range(const std::vector<_Entry> &entries, const _Box &box, int shift) {
+        int lo = 255, hi = 0;
+        for(size_t i = box.begin; i < box.end; ++i) {
+            int c = (entries[i].color >> shift) & 0xff;
+            lo = std::min(lo, c);
+            hi = std::max(hi, c);
+        }
+        return hi - lo;
+    }
+
+    //splits the entries into at most the given number of boxes, each time halving by count the box with the widest channel
+    static std::vector<_Box> _medianCut(std::vector<_Entry> &entries, int maxBoxes) {
+        std::vector<_Box> boxes;
+        _Box all = {0, entries.size()};
+        boxes.push_back(all);
+        while ((int)boxes.size() < maxBoxes) {
+            size_t best = 0;
+            int bestShift = -1, bestRange = 0;
+            for(size_t i = 0; i < boxes.size(); ++i) {
+                if (boxes[i].end - boxes[i].begin < 2) continue;
+                for(int shift = 0; shift < 32; shift += 8) {
+                    int range = _range(entries, boxes[i], shift);
+                    if (range > bestRange) {
+                        best = i;
+                        bestShift = shift;
+                        bestRange = range;
+                    }
+                }
+            }
+            if (bestShift < 0) break;
+
+            _Box &box = boxes[best];
+            std::sort(entries.begin() + box.begin, entries.begin() + box.end, [bestShift](const _Entry &a, const _Entry &b) {
+                return ((a.color >> bestShift) & 0xff) < ((b.color >> bestShift) & 0xff);
+            });
+            uint64_t total = 0, sum = 0;
+            for(size_t i = box.begin; i < box.end; ++i) total += entries[i].count;
+            size_t split = box.begin + 1;
+            for(size_t i = box.begin; i < box.end - 1; ++i) {
+                sum += entries[i].count;
+                split = i + 1;
+                if (sum * 2 >= total) break;
+            }
+            _Box upper = {split, box.end};
+            box.end = split;
+            boxes.push_back(upper);
+        }
+        return boxes;
+    }
+
+    //returns the count-weighted average color of a box
+    static uint32_t _average(const std::vector<_Entry> &entries, const _Box &box) {
+        uint64_t total = 0, sums[4] = {0, 0, 0, 0};
+        for(size_t i = box.begin; i < box.end; ++i) {
+            total += entries[i].count;
+            for(int c = 0; c < 4; ++c) {
+                sums[c] += (uint64_t)((entries[i].color >> (c * 8)) & 0xff) * entries[i].count;
+            }
+        }
+        uint32_t result = 0;
+        for(int c = 0; c < 4; ++c) {
+            result |= (uint32_t)((sums[c] + total / 2) / total) << (c * 8);
+        }
+        return result;
+    }
+
+#ifdef ALX_X86
+
+    //AVX2 kernel; it returns the number of pixels processed
+
+    ALX_TARGET_AVX2 static int _expandAVX2(uint32_t *dst, const uint8_t *src, int n, const uint32_t *palette) {
+        int i = 0;
+        for(; i + 16 <= n; i += 16) {
+            __m128i indices = _mm_loadu_si128((const __m128i *)(src + i));
+            __m256i lo = _mm256_cvtepu8_epi32(indices);
+            __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(indices, 8));
+            _mm256_storeu_si256((__m256i *)(dst + i), _mm256_i32gather_epi32((const int *)palette, lo, 4));
+            _mm256_storeu_si256((__m256i *)(dst + i + 8), _mm256_i32gather_epi32((const int *)palette, hi, 4));
+        }
+        return i;
+    }
+
+#endif //ALX_X86
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_INDEXED_BITMAP_HPP
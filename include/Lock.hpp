@@ -15,7 +15,7 @@ public:
         @param object object to lock.
      */
     Lock(T &object) : m_object(object) {
-        m_object.unlock();
+        m_object.lock();
     }
 
     /**
@@ -0,0 +1,190 @@
+#ifndef ALX_NINE_PATCH_HPP
+#define ALX_NINE_PATCH_HPP
+
+
+#include <algorithm>
+#include "Bitmap.hpp"
+#include "Size.hpp"
+#include "SpriteBatch.hpp"
+
+
+namespace alx {
+
+
+/**
+    A nine-slice panel: a bitmap split by border insets into four corners, four edges and a center.
+    Corners are drawn unscaled, edges are stretched (or tiled) along their length and the center is
+    stretched (or tiled) in both directions. The slice rects are computed once, on construction.
+    Panels are emitted as quads into a SpriteBatch, so that the slices of many panels that share a bitmap
+    are drawn with a single primitive call when the batch is flushed.
+    Panels smaller than the borders shrink the borders proportionally.
+ */
+class NinePatch {
+public:
+    /**
+        Constructor.
+        @param bitmap bitmap; it can be a sub-bitmap, e.g. of a texture atlas.
+        @param left width of the left border.
+        @param top height of the top border.
+        @param right width of the right border.
+        @param bottom height of the bottom border.
+        @param tiled if true, edges and center are tiled instead of stretched.
+     */
+    NinePatch(const Bitmap &bitmap, int left, int top, int right, int bottom, bool tiled = false) :
+        m_bitmap(bitmap),
+        m_tiled(tiled)
+    {
+        float w = (float)bitmap.getWidth(), h = (float)bitmap.getHeight();
+        m_sx[0] = 0;
+        m_sx[1] = std::min((float)left, w);
+        m_sx[2] = std::max(w - right, m_sx[1]);
+        m_sx[3] = w;
+        m_sy[0] = 0;
+        m_sy[1] = std::min((float)top, h);
+        m_sy[2] = std::max(h - bottom, m_sy[1]);
+        m_sy[3] = h;
+    }
+
+    /**
+        Returns the bitmap.
+        @return the bitmap.
+     */
+    const Bitmap &getBitmap() const {
+        return m_bitmap;
+    }
+
+    /**
+        Returns the size of the borders, i.e. the smallest size the panel is drawn at without shrinking them.
+        @return the size of the borders.
+     */
+    Size<float> getMinimumSize() const {
+        return Size<float>(m_sx[1] + m_sx[3] - m_sx[2], m_sy[1] + m_sy[3] - m_sy[2]);
+    }
+
+    /**
+        Checks if edges and center are tiled.
+        @return true if edges and center are tiled, false if they are stretched.
+     */
+    bool isTiled() const {
+        return m_tiled;
+    }
+
+    /**
+        Sets whether edges and center are tiled or stretched.
+        @param tiled if true, edges and center are tiled.
+     */
+    void setTiled(bool tiled) {
+        m_tiled = tiled;
+    }
+
+    /**
+        Adds a panel to a batch.
+        @param batch batch.
+        @param x left position of the panel.
+        @param y top position of the panel.
+        @param w width of the panel.
+        @param h height of the panel.
+     */
+    void draw(SpriteBatch &batch, float x, float y, float w, float h) const {
+        ALLEGRO_COLOR c = {1, 1, 1, 1};
+        draw(batch, c, x, y, w, h);
+    }
+
+    /**
+        Adds a tinted panel to a batch.
+        @param batch batch.
+        @param color tint color.
+        @param x left position of the panel.
+        @param y top position of the panel.
+        @param w width of the panel.
+        @param h height of the panel.
+     */
+    void draw(SpriteBatch &batch, const ALLEGRO_COLOR &color, float x, float y, float w, float h) const {
+        float dx[4], dy[4];
+        _edges(x, w, m_sx, dx);
+        _edges(y, h, m_sy, dy);
+        for(int row = 0; row < 3; ++row) {
+            for(int col = 0; col < 3; ++col) {
+                float sw = m_sx[col + 1] - m_sx[col], sh = m_sy[row + 1] - m_sy[row];
+                float dw = dx[col + 1] - dx[col], dh = dy[row + 1] - dy[row];
+                if (sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0) continue;
+                if (m_tiled && (row == 1 || col == 1)) {
+                    _tile(batch, color, m_sx[col], m_sy[row], sw, sh, dx[col], dy[row], dw, dh, col == 1, row == 1);
+                }
+                else {
+                    batch.drawTintedScaled(m_bitmap, color, m_sx[col], m_sy[row], sw, sh, dx[col], dy[row], dw, dh);
+                }
+            }
+        }
+    }
+
+    /**
+        Draws a panel onto the target bitmap with a single primitive call.
+        To draw many panels, add them to a SpriteBatch instead.
+        @param x left position of the panel.
+        @param y top position of the panel.
+        @param w width of the panel.
+        @param h height of the panel.
+     */
+    void draw(float x, float y, float w, float h) const {
+        SpriteBatch batch(false, 9);
+        draw(batch, x, y, w, h);
+    }
+
+    /**
+        Draws a tinted panel onto the target bitmap with a single primitive call.
+        To draw many panels, add them to a SpriteBatch instead.
+        @param color tint color.
+        @param x left position of the panel.
+        @param y top position of the panel.
+        @param w width of the panel.
+        @param h height of the panel.
+     */
+    void draw(const ALLEGRO_COLOR &color, float x, float y, float w, float h) const {
+        SpriteBatch batch(false, 9);
+        draw(batch, color, x, y, w, h);
+    }
+
+private:
+    //bitmap
+    Bitmap m_bitmap;
+
+    //slice edges in the bitmap: slice i spans from edge i to edge i + 1
+    float m_sx[4];
+    float m_sy[4];
+
+    //tiling mode
+    bool m_tiled;
+
+    //computes the slice edges of a panel along one axis, shrinking the borders if they do not fit
+    static void _edges(float pos, float size, const float *s, float *d) {
+        float first = s[1] - s[0], last = s[3] - s[2];
+        if (first + last > size) {
+            float f = size > 0 ? size / (first + last) : 0;
+            first *= f;
+            last *= f;
+        }
+        d[0] = pos;
+        d[1] = pos + first;
+        d[2] = pos + size - last;
+        d[3] = pos + size;
+    }
+
+    //adds a slice as unscaled tiles along the tiled axes; the last tile is cropped
+    void _tile(SpriteBatch &batch, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, bool tileX, bool tileY) const {
+        float stepX = tileX ? sw : dw, stepY = tileY ? sh : dh;
+        for(float ty = 0; ty < dh; ty += stepY) {
+            float th = std::min(stepY, dh - ty);
+            for(float tx = 0; tx < dw; tx += stepX) {
+                float tw = std::min(stepX, dw - tx);
+                batch.drawTintedScaled(m_bitmap, color, sx, sy, tileX ? tw : sw, tileY ? th : sh, dx + tx, dy + ty, tw, th);
+            }
+        }
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_NINE_PATCH_HPP
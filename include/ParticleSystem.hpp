@@ -0,0 +1,324 @@
+#ifndef ALX_PARTICLE_SYSTEM_HPP
+#define ALX_PARTICLE_SYSTEM_HPP
+
+
+#include <vector>
+#include <allegro5/allegro_primitives.h>
+#include "Cpu.hpp"
+#include "Bitmap.hpp"
+
+
+namespace alx {
+
+
+/**
+    A fixed-capacity particle system.
+    Particles are stored as a structure of arrays (position, velocity, color and remaining life, one float array each),
+    updated with AVX2 or SSE2 kernels when the processor supports them (see Cpu), and drawn as textured quads
+    with a single al_draw_indexed_prim call. Dead particles are removed by moving the last particle into their slot,
+    so the arrays are never reallocated after construction; the order of particles is not preserved.
+ */
+class ParticleSystem {
+public:
+    /**
+        Constructor.
+        @param capacity maximum number of live particles.
+        @param texture texture of the particles; if null, particles are drawn as colored squares.
+        @param size width and height of a particle, in pixels.
+     */
+    ParticleSystem(size_t capacity, const Bitmap &texture = Bitmap(), float size = 8) :
+        m_capacity(capacity),
+        m_count(0),
+        m_x(capacity),
+        m_y(capacity),
+        m_vx(capacity),
+        m_vy(capacity),
+        m_life(capacity),
+        m_red(capacity),
+        m_green(capacity),
+        m_blue(capacity),
+        m_alpha(capacity),
+        m_root(nullptr),
+        m_size(size),
+        m_ax(0),
+        m_ay(0)
+    {
+        setTexture(texture);
+    }
+
+    /**
+        Returns the maximum number of live particles.
+        @return the capacity.
+     */
+    size_t getCapacity() const {
+        return m_capacity;
+    }
+
+    /**
+        Returns the number of live particles.
+        @return the number of live particles.
+     */
+    size_t getCount() const {
+        return m_count;
+    }
+
+    /**
+        Returns the texture.
+        @return the texture.
+     */
+    const Bitmap &getTexture() const {
+        return m_texture;
+    }
+
+    /**
+        Sets the texture; the whole bitmap is mapped onto each particle.
+        @param texture texture; it can be a sub-bitmap, e.g. of a texture atlas; if null, particles are drawn as colored squares.
+     */
+    void setTexture(const Bitmap &texture) {
+        m_texture = texture;
+        m_root = nullptr;
+        m_u0 = m_v0 = m_u1 = m_v1 = 0;
+        if (!texture) return;
+        ALLEGRO_BITMAP *bitmap = texture.get();
+        m_u1 = (float)al_get_bitmap_width(bitmap);
+        m_v1 = (float)al_get_bitmap_height(bitmap);
+        while (ALLEGRO_BITMAP *parent = al_get_parent_bitmap(bitmap)) {
+            m_u0 += al_get_bitmap_x(bitmap);
+            m_v0 += al_get_bitmap_y(bitmap);
+            bitmap = parent;
+        }
+        m_u1 += m_u0;
+        m_v1 += m_v0;
+        m_root = bitmap;
+    }
+
+    /**
+        Returns the size of a particle.
+        @return the width and height of a particle, in pixels.
+     */
+    float getSize() const {
+        return m_size;
+    }
+
+    /**
+        Sets the size of a particle.
+        @param size width and height of a particle, in pixels.
+     */
+    void setSize(float size) {
+        m_size = size;
+    }
+
+    /**
+        Sets the acceleration applied to all particles, e.g. gravity.
+        @param ax horizontal acceleration, in pixels per second squared.
+        @param ay vertical acceleration, in pixels per second squared.
+     */
+    void setAcceleration(float ax, float ay) {
+        m_ax = ax;
+        m_ay = ay;
+    }
+
+    /**
+        Adds a particle.
+        @param x horizontal position of the center.
+        @param y vertical position of the center.
+        @param vx horizontal velocity, in pixels per second.
+        @param vy vertical velocity, in pixels per second.
+        @param life life, in seconds.
+        @param color color.
+        @return false if the system is full.
+     */
+    bool emit(float x, float y, float vx, float vy, float life, const ALLEGRO_COLOR &color) {
+        if (m_count == m_capacity) return false;
+        size_t i = m_count++;
+        m_x[i] = x;
+        m_y[i] = y;
+        m_vx[i] = vx;
+        m_vy[i] = vy;
+        m_life[i] = life;
+        m_red[i] = color.r;
+        m_green[i] = color.g;
+        m_blue[i] = color.b;
+        m_alpha[i] = color.a;
+        return true;
+    }
+
+    /**
+        Advances the particles and removes the dead ones.
+        @param dt elapsed time, in seconds.
+     */
+    void update(float dt) {
+        if (m_count == 0) return;
+        float dvx = m_ax * dt, dvy = m_ay * dt;
+        bool dead = false;
+        size_t i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _updateAVX2(&m_x[0], &m_y[0], &m_vx[0], &m_vy[0], &m_life[0], m_count, dt, dvx, dvy, dead);
+        else if (Cpu::hasSSE2()) i = _updateSSE2(&m_x[0], &m_y[0], &m_vx[0], &m_vy[0], &m_life[0], m_count, dt, dvx, dvy, dead);
+#endif
+        for(; i < m_count; ++i) {
+            m_vx[i] += dvx;
+            m_vy[i] += dvy;
+            m_x[i] += m_vx[i] * dt;
+            m_y[i] += m_vy[i] * dt;
+            m_life[i] -= dt;
+            dead |= m_life[i] <= 0;
+        }
+        if (dead) _compact();
+    }
+
+    /**
+        Removes all particles.
+     */
+    void clear() {
+        m_count = 0;
+    }
+
+    /**
+        Draws the particles onto the target bitmap with a single primitive call.
+        Particles are transformed by the current transform.
+     */
+    void draw() {
+        if (m_count == 0) return;
+
+        //the index pattern only depends on the particle count; build it once for the whole capacity
+        if (m_indices.empty()) {
+            m_indices.resize(m_capacity * 6);
+            for(size_t i = 0; i < m_capacity; ++i) {
+                int v = (int)i * 4;
+                int *p = &m_indices[i * 6];
+                p[0] = v;
+                p[1] = v + 1;
+                p[2] = v + 2;
+                p[3] = v;
+                p[4] = v + 2;
+                p[5] = v + 3;
+            }
+        }
+
+        m_vertices.resize(m_count * 4);
+        float h = m_size * 0.5f;
+        for(size_t i = 0; i < m_count; ++i) {
+            ALLEGRO_COLOR color = {m_red[i], m_green[i], m_blue[i], m_alpha[i]};
+            float x0 = m_x[i] - h, y0 = m_y[i] - h, x1 = m_x[i] + h, y1 = m_y[i] + h;
+            ALLEGRO_VERTEX *v = &m_vertices[i * 4];
+            _vertex(v[0], x0, y0, m_u0, m_v0, color);
+            _vertex(v[1], x1, y0, m_u1, m_v0, color);
+            _vertex(v[2], x1, y1, m_u1, m_v1, color);
+            _vertex(v[3], x0, y1, m_u0, m_v1, color);
+        }
+        al_draw_indexed_prim(m_vertices.data(), nullptr, m_root, m_indices.data(), (int)(m_count * 6), ALLEGRO_PRIM_TRIANGLE_LIST);
+    }
+
+private:
+    //counts
+    size_t m_capacity;
+    size_t m_count;
+
+    //particles
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_vx;
+    std::vector<float> m_vy;
+    std::vector<float> m_life;
+    std::vector<float> m_red;
+    std::vector<float> m_green;
+    std::vector<float> m_blue;
+    std::vector<float> m_alpha;
+
+    //appearance
+    Bitmap m_texture;
+    ALLEGRO_BITMAP *m_root;
+    float m_u0, m_v0, m_u1, m_v1;
+    float m_size;
+
+    //acceleration
+    float m_ax;
+    float m_ay;
+
+    //draw buffers
+    std::vector<ALLEGRO_VERTEX> m_vertices;
+    std::vector<int> m_indices;
+
+    //sets a vertex
+    static void _vertex(ALLEGRO_VERTEX &v, float x, float y, float u, float t, const ALLEGRO_COLOR &color) {
+        v.x = x;
+        v.y = y;
+        v.z = 0;
+        v.u = u;
+        v.v = t;
+        v.color = color;
+    }
+
+    //removes dead particles by moving the last live particle into their slot
+    void _compact() {
+        for(size_t i = 0; i < m_count; ) {
+            if (m_life[i] > 0) {
+                ++i;
+                continue;
+            }
+            size_t last = --m_count;
+            m_x[i] = m_x[last];
+            m_y[i] = m_y[last];
+            m_vx[i] = m_vx[last];
+            m_vy[i] = m_vy[last];
+            m_life[i] = m_life[last];
+            m_red[i] = m_red[last];
+            m_green[i] = m_green[last];
+            m_blue[i] = m_blue[last];
+            m_alpha[i] = m_alpha[last];
+        }
+    }
+
+#ifdef ALX_X86
+
+    //SSE2 kernels; they return the number of elements processed
+
+    ALX_TARGET_SSE2 static size_t _updateSSE2(float *x, float *y, float *vx, float *vy, float *life, size_t n, float dt, float dvx, float dvy, bool &dead) {
+        const __m128 t = _mm_set1_ps(dt), ax = _mm_set1_ps(dvx), ay = _mm_set1_ps(dvy), zero = _mm_setzero_ps();
+        __m128 expired = zero;
+        size_t i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128 u = _mm_add_ps(_mm_loadu_ps(vx + i), ax);
+            __m128 v = _mm_add_ps(_mm_loadu_ps(vy + i), ay);
+            _mm_storeu_ps(vx + i, u);
+            _mm_storeu_ps(vy + i, v);
+            _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(u, t)));
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(v, t)));
+            __m128 l = _mm_sub_ps(_mm_loadu_ps(life + i), t);
+            _mm_storeu_ps(life + i, l);
+            expired = _mm_or_ps(expired, _mm_cmple_ps(l, zero));
+        }
+        dead = _mm_movemask_ps(expired) != 0;
+        return i;
+    }
+
+    //AVX2 kernels; they return the number of elements processed
+
+    ALX_TARGET_AVX2 static size_t _updateAVX2(float *x, float *y, float *vx, float *vy, float *life, size_t n, float dt, float dvx, float dvy, bool &dead) {
+        const __m256 t = _mm256_set1_ps(dt), ax = _mm256_set1_ps(dvx), ay = _mm256_set1_ps(dvy), zero = _mm256_setzero_ps();
+        __m256 expired = zero;
+        size_t i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256 u = _mm256_add_ps(_mm256_loadu_ps(vx + i), ax);
+            __m256 v = _mm256_add_ps(_mm256_loadu_ps(vy + i), ay);
+            _mm256_storeu_ps(vx + i, u);
+            _mm256_storeu_ps(vy + i, v);
+            _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(u, t)));
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(v, t)));
+            __m256 l = _mm256_sub_ps(_mm256_loadu_ps(life + i), t);
+            _mm256_storeu_ps(life + i, l);
+            expired = _mm256_or_ps(expired, _mm256_cmp_ps(l, zero, _CMP_LE_OQ));
+        }
+        dead = _mm256_movemask_ps(expired) != 0;
+        return i;
+    }
+
+#endif //ALX_X86
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_PARTICLE_SYSTEM_HPP
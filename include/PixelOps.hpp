@@ -0,0 +1,532 @@
+#ifndef ALX_PIXEL_OPS_HPP
+#define ALX_PIXEL_OPS_HPP
+
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "Cpu.hpp"
+#include "Bitmap.hpp"
+
+
+namespace alx {
+
+
+/**
+    Bulk operations on the pixels of locked bitmaps.
+    The operations work on 32-bit pixel formats and use AVX2 or SSE2 kernels when the processor supports them,
+    falling back to plain c++ otherwise (see Cpu).
+    The region-level functions return false if the lock failed or its format is not supported.
+    The row-level functions are public so that other bulk code can reuse them.
+ */
+class PixelOps {
+public:
+    /**
+        Fills a locked region with a pixel value.
+        @param lock lock.
+        @param value 32-bit pixel value, in the format of the lock.
+        @return true on success.
+     */
+    static bool fill(const Bitmap::Lock &lock, uint32_t value) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region || region->pixel_size != 4) return false;
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            fillRow(_row(region, y), lock.getWidth(), value);
+        }
+        return true;
+    }
+
+    /**
+        Fills a locked region with a color.
+        @param lock lock.
+        @param color color.
+        @return true on success.
+     */
+    static bool fill(const Bitmap::Lock &lock, const ALLEGRO_COLOR &color) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        uint32_t value;
+        return region && pack(region->format, color, value) && fill(lock, value);
+    }
+
+    /**
+        Copies pixels between two locked regions of the same pixel size.
+        The overlapping area of the two regions is copied.
+        @param dst destination lock.
+        @param src source lock.
+        @return true on success.
+     */
+    static bool copy(const Bitmap::Lock &dst, const Bitmap::Lock &src) {
+        const ALLEGRO_LOCKED_REGION *d = dst.getLockedRegion(), *s = src.getLockedRegion();
+        if (!d || !s || d->pixel_size != s->pixel_size) return false;
+        int width = std::min(dst.getWidth(), src.getWidth());
+        int height = std::min(dst.getHeight(), src.getHeight());
+        for(int y = 0; y < height; ++y) {
+            std::memcpy((uint8_t *)d->data + y * d->pitch, (const uint8_t *)s->data + y * s->pitch, width * d->pixel_size);
+        }
+        return true;
+    }
+
+    /**
+        Multiplies the color components of each pixel by its alpha.
+        @param lock lock.
+        @return true on success.
+     */
+    static bool premultiplyAlpha(const Bitmap::Lock &lock) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        int r, g, b, a;
+        if (!region || !getShifts(region->format, r, g, b, a) || a < 0) return false;
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            premultiplyRow(_row(region, y), lock.getWidth(), a);
+        }
+        return true;
+    }
+
+    /**
+        Divides the color components of each pixel by its alpha.
+        @param lock lock.
+        @return true on success.
+     */
+    static bool unpremultiplyAlpha(const Bitmap::Lock &lock) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        int r, g, b, a;
+        if (!region || !getShifts(region->format, r, g, b, a) || a < 0) return false;
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            unpremultiplyRow(_row(region, y), lock.getWidth(), a);
+        }
+        return true;
+    }
+
+    /**
+        Multiplies each pixel by a color, component-wise.
+        @param lock lock.
+        @param color tint color.
+        @return true on success.
+     */
+    static bool tint(const Bitmap::Lock &lock, const ALLEGRO_COLOR &color) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        uint32_t factors;
+        if (!region || !pack(region->format, color, factors)) return false;
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            tintRow(_row(region, y), lock.getWidth(), factors);
+        }
+        return true;
+    }
+
+    /**
+        Replaces the pixels of the given color with transparent black.
+        @param lock lock.
+        @param color mask color.
+        @return true on success.
+     */
+    static bool convertMaskToAlpha(const Bitmap::Lock &lock, const ALLEGRO_COLOR &color) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        int r, g, b, a;
+        uint32_t key;
+        if (!region || !getShifts(region->format, r, g, b, a) || a < 0 || !pack(region->format, color, key)) return false;
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            maskRow(_row(region, y), lock.getWidth(), key);
+        }
+        return true;
+    }
+
+    /**
+        Replaces the pixels of the given color with transparent black.
+        A faster replacement for Bitmap::convertMaskToAlpha;
+        it falls back to it if the bitmap's format is not supported.
+        @param bitmap bitmap.
+        @param color mask color.
+     */
+    static void convertMaskToAlpha(Bitmap &bitmap, const ALLEGRO_COLOR &color) {
+        bool done;
+        {
+            Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ANY, ALLEGRO_LOCK_READWRITE);
+            done = convertMaskToAlpha(lock, color);
+        }
+        if (!done) bitmap.convertMaskToAlpha(color);
+    }
+
+    /**
+        Reorders the bytes of each pixel.
+        Byte i of the result (bits 8*i to 8*i+7) is taken from byte order[i] of the source.
+        @param lock lock.
+        @param order source byte index, from 0 to 3, for each of the 4 destination bytes.
+        @return true on success.
+     */
+    static bool swizzle(const Bitmap::Lock &lock, const int order[4]) {
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region || region->pixel_size != 4) return false;
+        for(int i = 0; i < 4; ++i) {
+            if (order[i] < 0 || order[i] > 3) return false;
+        }
+        for(int y = 0; y < lock.getHeight(); ++y) {
+            swizzleRow(_row(region, y), lock.getWidth(), order);
+        }
+        return true;
+    }
+
+    /**
+        Returns the bit positions of the color components of a 32-bit pixel format.
+        @param format pixel format.
+        @param r shift of the red component.
+        @param g shift of the green component.
+        @param b shift of the blue component.
+        @param a shift of the alpha component; -1 if the format has no alpha.
+        @return false if the format is not supported.
+     */
+    static bool getShifts(int format, int &r, int &g, int &b, int &a) {
+        switch (format) {
+            case ALLEGRO_PIXEL_FORMAT_ARGB_8888: r = 16; g =  8; b =  0; a = 24; return true;
+            case ALLEGRO_PIXEL_FORMAT_RGBA_8888: r = 24; g = 16; b =  8; a =  0; return true;
+            case ALLEGRO_PIXEL_FORMAT_ABGR_8888: r =  0; g =  8; b = 16; a = 24; return true;
+            case ALLEGRO_PIXEL_FORMAT_XRGB_8888: r = 16; g =  8; b =  0; a = -1; return true;
+            case ALLEGRO_PIXEL_FORMAT_XBGR_8888: r =  0; g =  8; b = 16; a = -1; return true;
+            case ALLEGRO_PIXEL_FORMAT_RGBX_8888: r = 24; g = 16; b =  8; a = -1; return true;
+#ifdef ALLEGRO_BIG_ENDIAN
+            case ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE: r = 24; g = 16; b =  8; a =  0; return true;
+#else
+            case ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE: r =  0; g =  8; b = 16; a = 24; return true;
+#endif
+        }
+        return false;
+    }
+
+    /**
+        Packs a color into a 32-bit pixel of the given format.
+        @param format pixel format.
+        @param color color.
+        @param value the packed pixel.
+        @return false if the format is not supported.
+     */
+    static bool pack(int format, const ALLEGRO_COLOR &color, uint32_t &value) {
+        int rs, gs, bs, as;
+        if (!getShifts(format, rs, gs, bs, as)) return false;
+        unsigned char r, g, b, a;
+        al_unmap_rgba(color, &r, &g, &b, &a);
+        value = ((uint32_t)r << rs) | ((uint32_t)g << gs) | ((uint32_t)b << bs);
+        if (as >= 0) value |= (uint32_t)a << as;
+        return true;
+    }
+
+    /**
+        Fills a row of pixels.
+        @param p pixels.
+        @param n number of pixels.
+        @param value pixel value.
+     */
+    static void fillRow(uint32_t *p, int n, uint32_t value) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _fillAVX2(p, n, value);
+        else if (Cpu::hasSSE2()) i = _fillSSE2(p, n, value);
+#endif
+        for(; i < n; ++i) p[i] = value;
+    }
+
+    /**
+        Premultiplies a row of pixels by alpha.
+        @param p pixels.
+        @param n number of pixels.
+        @param alphaShift bit position of the alpha component.
+     */
+    static void premultiplyRow(uint32_t *p, int n, int alphaShift) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _premultiplyAVX2(p, n, alphaShift);
+        else if (Cpu::hasSSE2()) i = _premultiplySSE2(p, n, alphaShift);
+#endif
+        for(; i < n; ++i) {
+            uint32_t a = (p[i] >> alphaShift) & 0xff;
+            uint32_t factors = (a * 0x01010101u) | (0xffu << alphaShift);
+            p[i] = _mulBytes(p[i], factors);
+        }
+    }
+
+    /**
+        Unpremultiplies a row of pixels by alpha; pixels with zero alpha are left unchanged.
+        @param p pixels.
+        @param n number of pixels.
+        @param alphaShift bit position of the alpha component.
+     */
+    static void unpremultiplyRow(uint32_t *p, int n, int alphaShift) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _unpremultiplyAVX2(p, n, alphaShift);
+        else if (Cpu::hasSSE2()) i = _unpremultiplySSE2(p, n, alphaShift);
+#endif
+        for(; i < n; ++i) {
+            uint32_t a = (p[i] >> alphaShift) & 0xff;
+            if (a == 0) continue;
+            uint32_t result = a << alphaShift;
+            for(int shift = 0; shift < 32; shift += 8) {
+                if (shift == alphaShift) continue;
+                float c = (float)((p[i] >> shift) & 0xff);
+                uint32_t v = (uint32_t)std::min(c * 255.0f / (float)a + 0.5f, 255.0f);
+                result |= v << shift;
+            }
+            p[i] = result;
+        }
+    }
+
+    /**
+        Multiplies the bytes of a row of pixels by the bytes of a factor pixel; 255 stands for 1.
+        @param p pixels.
+        @param n number of pixels.
+        @param factors packed factors.
+     */
+    static void tintRow(uint32_t *p, int n, uint32_t factors) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _tintAVX2(p, n, factors);
+        else if (Cpu::hasSSE2()) i = _tintSSE2(p, n, factors);
+#endif
+        for(; i < n; ++i) p[i] = _mulBytes(p[i], factors);
+    }
+
+    /**
+        Replaces the pixels equal to a key with zero.
+        @param p pixels.
+        @param n number of pixels.
+        @param key key pixel.
+     */
+    static void maskRow(uint32_t *p, int n, uint32_t key) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _maskAVX2(p, n, key);
+        else if (Cpu::hasSSE2()) i = _maskSSE2(p, n, key);
+#endif
+        for(; i < n; ++i) {
+            if (p[i] == key) p[i] = 0;
+        }
+    }
+
+    /**
+        Reorders the bytes of a row of pixels.
+        @param p pixels.
+        @param n number of pixels.
+        @param order source byte index, from 0 to 3, for each of the 4 destination bytes.
+     */
+    static void swizzleRow(uint32_t *p, int n, const int order[4]) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _swizzleAVX2(p, n, order);
+        else if (Cpu::hasSSE2()) i = _swizzleSSE2(p, n, order);
+#endif
+        for(; i < n; ++i) {
+            uint32_t v = p[i], r = 0;
+            for(int j = 0; j < 4; ++j) {
+                r |= ((v >> (order[j] * 8)) & 0xff) << (j * 8);
+            }
+            p[i] = r;
+        }
+    }
+
+private:
+    //returns a row of a locked region
+    static uint32_t *_row(const ALLEGRO_LOCKED_REGION *region, int y) {
+        return reinterpret_cast<uint32_t *>((uint8_t *)region->data + y * region->pitch);
+    }
+
+    //multiplies bytes; x * f / 255, rounded
+    static uint32_t _mulBytes(uint32_t v, uint32_t f) {
+        uint32_t r = 0;
+        for(int shift = 0; shift < 32; shift += 8) {
+            uint32_t t = ((v >> shift) & 0xff) * ((f >> shift) & 0xff) + 128;
+            r |= (((t + (t >> 8)) >> 8) & 0xff) << shift;
+        }
+        return r;
+    }
+
+#ifdef ALX_X86
+    //SSE2 kernels; they return the number of pixels processed
+
+    ALX_TARGET_SSE2 static __m128i _mulBytesSSE2(__m128i v, __m128i f) {
+        __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi16(128);
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), _mm_unpacklo_epi8(f, zero)), bias);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), _mm_unpackhi_epi8(f, zero)), bias);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    ALX_TARGET_SSE2 static __m128i _alphaFactorsSSE2(__m128i v, int alphaShift) {
+        __m128i a = _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(alphaShift)), _mm_set1_epi32(0xff));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+        return _mm_or_si128(a, _mm_set1_epi32((int)(0xffu << alphaShift)));
+    }
+
+    ALX_TARGET_SSE2 static int _fillSSE2(uint32_t *p, int n, uint32_t value) {
+        __m128i v = _mm_set1_epi32((int)value);
+        int i = 0;
+        for(; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i *)(p + i), v);
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static int _premultiplySSE2(uint32_t *p, int n, int alphaShift) {
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            _mm_storeu_si128((__m128i *)(p + i), _mulBytesSSE2(v, _alphaFactorsSSE2(v, alphaShift)));
+        }
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static int _unpremultiplySSE2(uint32_t *p, int n, int alphaShift) {
+        __m128i byteMask = _mm_set1_epi32(0xff), zero = _mm_setzero_si128();
+        __m128i alphaMask = _mm_set1_epi32((int)(0xffu << alphaShift));
+        __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f), limit = _mm_set1_ps(255.0f);
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            __m128i ai = _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(alphaShift)), byteMask);
+            __m128 a = _mm_cvtepi32_ps(ai);
+            __m128i result = _mm_and_si128(v, alphaMask);
+            for(int shift = 0; shift < 32; shift += 8) {
+                if (shift == alphaShift) continue;
+                __m128i count = _mm_cvtsi32_si128(shift);
+                __m128 c = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(v, count), byteMask));
+                c = _mm_min_ps(_mm_add_ps(_mm_div_ps(_mm_mul_ps(c, scale), a), half), limit);
+                result = _mm_or_si128(result, _mm_sll_epi32(_mm_cvttps_epi32(c), count));
+            }
+            __m128i transparent = _mm_cmpeq_epi32(ai, zero);
+            result = _mm_or_si128(_mm_and_si128(transparent, v), _mm_andnot_si128(transparent, result));
+            _mm_storeu_si128((__m128i *)(p + i), result);
+        }
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static int _tintSSE2(uint32_t *p, int n, uint32_t factors) {
+        __m128i f = _mm_set1_epi32((int)factors);
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            _mm_storeu_si128((__m128i *)(p + i), _mulBytesSSE2(v, f));
+        }
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static int _maskSSE2(uint32_t *p, int n, uint32_t key) {
+        __m128i k = _mm_set1_epi32((int)key);
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            _mm_storeu_si128((__m128i *)(p + i), _mm_andnot_si128(_mm_cmpeq_epi32(v, k), v));
+        }
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static int _swizzleSSE2(uint32_t *p, int n, const int order[4]) {
+        __m128i byteMask = _mm_set1_epi32(0xff);
+        __m128i src[4], dst[4];
+        for(int j = 0; j < 4; ++j) {
+            src[j] = _mm_cvtsi32_si128(order[j] * 8);
+            dst[j] = _mm_cvtsi32_si128(j * 8);
+        }
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            __m128i r = _mm_setzero_si128();
+            for(int j = 0; j < 4; ++j) {
+                r = _mm_or_si128(r, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(v, src[j]), byteMask), dst[j]));
+            }
+            _mm_storeu_si128((__m128i *)(p + i), r);
+        }
+        return i;
+    }
+
+    //AVX2 kernels; they return the number of pixels processed
+
+    ALX_TARGET_AVX2 static __m256i _mulBytesAVX2(__m256i v, __m256i f) {
+        __m256i zero = _mm256_setzero_si256(), bias = _mm256_set1_epi16(128);
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(v, zero), _mm256_unpacklo_epi8(f, zero)), bias);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(v, zero), _mm256_unpackhi_epi8(f, zero)), bias);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+        return _mm256_packus_epi16(lo, hi);
+    }
+
+    ALX_TARGET_AVX2 static int _fillAVX2(uint32_t *p, int n, uint32_t value) {
+        __m256i v = _mm256_set1_epi32((int)value);
+        int i = 0;
+        for(; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i *)(p + i), v);
+        return i;
+    }
+
+    ALX_TARGET_AVX2 static int _premultiplyAVX2(uint32_t *p, int n, int alphaShift) {
+        __m128i count = _mm_cvtsi32_si128(alphaShift);
+        __m256i byteMask = _mm256_set1_epi32(0xff), ones = _mm256_set1_epi32(0x01010101);
+        __m256i alphaMask = _mm256_set1_epi32((int)(0xffu << alphaShift));
+        int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            __m256i a = _mm256_and_si256(_mm256_srl_epi32(v, count), byteMask);
+            __m256i f = _mm256_or_si256(_mm256_mullo_epi32(a, ones), alphaMask);
+            _mm256_storeu_si256((__m256i *)(p + i), _mulBytesAVX2(v, f));
+        }
+        return i;
+    }
+
+    ALX_TARGET_AVX2 static int _unpremultiplyAVX2(uint32_t *p, int n, int alphaShift) {
+        __m256i byteMask = _mm256_set1_epi32(0xff), zero = _mm256_setzero_si256();
+        __m256i alphaMask = _mm256_set1_epi32((int)(0xffu << alphaShift));
+        __m256 scale = _mm256_set1_ps(255.0f), half = _mm256_set1_ps(0.5f), limit = _mm256_set1_ps(255.0f);
+        int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            __m256i ai = _mm256_and_si256(_mm256_srl_epi32(v, _mm_cvtsi32_si128(alphaShift)), byteMask);
+            __m256 a = _mm256_cvtepi32_ps(ai);
+            __m256i result = _mm256_and_si256(v, alphaMask);
+            for(int shift = 0; shift < 32; shift += 8) {
+                if (shift == alphaShift) continue;
+                __m128i count = _mm_cvtsi32_si128(shift);
+                __m256 c = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(v, count), byteMask));
+                c = _mm256_min_ps(_mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(c, scale), a), half), limit);
+                result = _mm256_or_si256(result, _mm256_sll_epi32(_mm256_cvttps_epi32(c), count));
+            }
+            result = _mm256_blendv_epi8(result, v, _mm256_cmpeq_epi32(ai, zero));
+            _mm256_storeu_si256((__m256i *)(p + i), result);
+        }
+        return i;
+    }
+
+    ALX_TARGET_AVX2 static int _tintAVX2(uint32_t *p, int n, uint32_t factors) {
+        __m256i f = _mm256_set1_epi32((int)factors);
+        int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            _mm256_storeu_si256((__m256i *)(p + i), _mulBytesAVX2(v, f));
+        }
+        return i;
+    }
+
+    ALX_TARGET_AVX2 static int _maskAVX2(uint32_t *p, int n, uint32_t key) {
+        __m256i k = _mm256_set1_epi32((int)key);
+        int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            _mm256_storeu_si256((__m256i *)(p + i), _mm256_andnot_si256(_mm256_cmpeq_epi32(v, k), v));
+        }
+        return i;
+    }
+
+    ALX_TARGET_AVX2 static int _swizzleAVX2(uint32_t *p, int n, const int order[4]) {
+        char control[32];
+        for(int j = 0; j < 32; ++j) {
+            control[j] = (char)((j & ~3) + order[j & 3]);
+        }
+        __m256i c = _mm256_loadu_si256((const __m256i *)control);
+        int i = 0;
+        for(; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            _mm256_storeu_si256((__m256i *)(p + i), _mm256_shuffle_epi8(v, c));
+        }
+        return i;
+    }
+#endif
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_PIXEL_OPS_HPP
@@ -0,0 +1,372 @@
+#ifndef ALX_PIXEL_VIEW_HPP
+#define ALX_PIXEL_VIEW_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include "Bitmap.hpp"
+
+
+namespace alx {
+
+
+/**
+    Compile-time descriptions of Allegro pixel formats, for use with PixelView.
+    Each format provides the pixel type, the Allegro format constant,
+    and functions to pack and unpack 8-bit color components.
+ */
+namespace PixelFormat {
+
+
+/**
+    32-bit pixels of the form 0xAARRGGBB.
+ */
+struct ARGB_8888 {
+    typedef uint32_t Pixel;
+    static const int Format = ALLEGRO_PIXEL_FORMAT_ARGB_8888;
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) { return ((Pixel)a << 24) | ((Pixel)r << 16) | ((Pixel)g << 8) | b; }
+    static uint8_t getRed(Pixel p) { return (uint8_t)(p >> 16); }
+    static uint8_t getGreen(Pixel p) { return (uint8_t)(p >> 8); }
+    static uint8_t getBlue(Pixel p) { return (uint8_t)p; }
+    static uint8_t getAlpha(Pixel p) { return (uint8_t)(p >> 24); }
+};
+
+
+/**
+    32-bit pixels of the form 0xRRGGBBAA.
+ */
+struct RGBA_8888 {
+    typedef uint32_t Pixel;
+    static const int Format = ALLEGRO_PIXEL_FORMAT_RGBA_8888;
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) { return ((Pixel)r << 24) | ((Pixel)g << 16) | ((Pixel)b << 8) | a; }
+    static uint8_t getRed(Pixel p) { return (uint8_t)(p >> 24); }
+    static uint8_t getGreen(Pixel p) { return (uint8_t)(p >> 16); }
+    static uint8_t getBlue(Pixel p) { return (uint8_t)(p >> 8); }
+    static uint8_t getAlpha(Pixel p) { return (uint8_t)p; }
+};
+
+
+/**
+    32-bit pixels of the form 0xAABBGGRR.
+ */
+struct ABGR_8888 {
+    typedef uint32_t Pixel;
+    static const int Format = ALLEGRO_PIXEL_FORMAT_ABGR_8888;
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) { return ((Pixel)a << 24) | ((Pixel)b << 16) | ((Pixel)g << 8) | r; }
+    static uint8_t getRed(Pixel p) { return (uint8_t)p; }
+    static uint8_t getGreen(Pixel p) { return (uint8_t)(p >> 8); }
+    static uint8_t getBlue(Pixel p) { return (uint8_t)(p >> 16); }
+    static uint8_t getAlpha(Pixel p) { return (uint8_t)(p >> 24); }
+};
+
+
+/**
+    32-bit pixels with the bytes R, G, B, A in memory order, regardless of endianess.
+ */
+struct ABGR_8888_LE {
+    typedef uint32_t Pixel;
+    static const int Format = ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE;
+#ifdef ALLEGRO_BIG_ENDIAN
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) { return RGBA_8888::pack(r, g, b, a); }
+    static uint8_t getRed(Pixel p) { return RGBA_8888::getRed(p); }
+    static uint8_t getGreen(Pixel p) { return RGBA_8888::getGreen(p); }
+    static uint8_t getBlue(Pixel p) { return RGBA_8888::getBlue(p); }
+    static uint8_t getAlpha(Pixel p) { return RGBA_8888::getAlpha(p); }
+#else
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) { return ABGR_8888::pack(r, g, b, a); }
+    static uint8_t getRed(Pixel p) { return ABGR_8888::getRed(p); }
+    static uint8_t getGreen(Pixel p) { return ABGR_8888::getGreen(p); }
+    static uint8_t getBlue(Pixel p) { return ABGR_8888::getBlue(p); }
+    static uint8_t getAlpha(Pixel p) { return ABGR_8888::getAlpha(p); }
+#endif
+};
+
+
+/**
+    32-bit pixels of the form 0x..RRGGBB; alpha is always 255.
+ */
+struct XRGB_8888 {
+    typedef uint32_t Pixel;
+    static const int Format = ALLEGRO_PIXEL_FORMAT_XRGB_8888;
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t = 255) { return ((Pixel)r << 16) | ((Pixel)g << 8) | b; }
+    static uint8_t getRed(Pixel p) { return (uint8_t)(p >> 16); }
+    static uint8_t getGreen(Pixel p) { return (uint8_t)(p >> 8); }
+    static uint8_t getBlue(Pixel p) { return (uint8_t)p; }
+    static uint8_t getAlpha(Pixel) { return 255; }
+};
+
+
+/**
+    16-bit pixels with 5 bits of red, 6 of green and 5 of blue; alpha is always 255.
+ */
+struct RGB_565 {
+    typedef uint16_t Pixel;
+    static const int Format = ALLEGRO_PIXEL_FORMAT_RGB_565;
+    static Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t = 255) { return (Pixel)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)); }
+    static uint8_t getRed(Pixel p) { uint8_t c = (p >> 11) & 0x1f; return (uint8_t)((c << 3) | (c >> 2)); }
+    static uint8_t getGreen(Pixel p) { uint8_t c = (p >> 5) & 0x3f; return (uint8_t)((c << 2) | (c >> 4)); }
+    static uint8_t getBlue(Pixel p) { uint8_t c = p & 0x1f; return (uint8_t)((c << 3) | (c >> 2)); }
+    static uint8_t getAlpha(Pixel) { return 255; }
+};
+
+
+} //namespace PixelFormat
+
+
+/**
+    Typed view over the pixels of a locked bitmap region.
+    The format is fixed at compile time, so per-pixel access compiles down to plain loads and stores.
+    The view does not own the lock; it must not outlive it.
+    @param F pixel format; one of the PixelFormat structures.
+ */
+template <class F> class PixelView {
+public:
+    /**
+        Pixel type.
+     */
+    typedef typename F::Pixel Pixel;
+
+    /**
+        Iterator over the rows of the view; dereferencing yields a pointer to the first pixel of the row.
+     */
+    class RowIterator {
+    public:
+        /**
+            Iterator traits; std::iterator is deprecated since C++17.
+         */
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Pixel *value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Pixel **pointer;
+        typedef Pixel *reference;
+
+        /**
+            Constructor.
+            @param row pointer to the row.
+            @param pitch distance between rows, in bytes.
+         */
+        RowIterator(uint8_t *row = nullptr, int pitch = 0) : m_row(row), m_pitch(pitch) {
+        }
+
+        /**
+            Returns the row.
+            @return pointer to the first pixel of the row.
+         */
+        Pixel *operator *() const {
+            return reinterpret_cast<Pixel *>(m_row);
+        }
+
+        /**
+            Moves to the next row.
+            @return reference to this.
+         */
+        RowIterator &operator ++() {
+            m_row += m_pitch;
+            return *this;
+        }
+
+        /**
+            Moves to the next row.
+            @return the previous position.
+         */
+        RowIterator operator ++(int) {
+            RowIterator it = *this;
+            m_row += m_pitch;
+            return it;
+        }
+
+        /**
+            Equality test.
+         */
+        bool operator == (const RowIterator &it) const {
+            return m_row == it.m_row;
+        }
+
+        /**
+            Difference test.
+         */
+        bool operator != (const RowIterator &it) const {
+            return m_row != it.m_row;
+        }
+
+    private:
+        uint8_t *m_row;
+        int m_pitch;
+    };
+
+    /**
+        Constructor from a lock.
+        If the lock failed or was made with another format, the view is null.
+        @param lock lock.
+     */
+    PixelView(const Bitmap::Lock &lock) {
+        _set(lock.getLockedRegion(), lock.getWidth(), lock.getHeight());
+    }
+
+    /**
+        Constructor from a locked region.
+        If the region is null or has another format, the view is null.
+        @param region locked region.
+        @param width width of the locked region.
+        @param height height of the locked region.
+     */
+    PixelView(const ALLEGRO_LOCKED_REGION *region, int width, int height) {
+        _set(region, width, height);
+    }
+
+    /**
+        Checks if the view is valid.
+        @return true if the view points to pixels of the right format.
+     */
+    bool isValid() const {
+        return m_data != nullptr;
+    }
+
+    /**
+        Checks if the view is valid.
+        @return true if the view points to pixels of the right format.
+     */
+    explicit operator bool () const {
+        return m_data != nullptr;
+    }
+
+    /**
+        Returns the width.
+        @return the width in pixels.
+     */
+    int getWidth() const {
+        return m_width;
+    }
+
+    /**
+        Returns the height.
+        @return the height in pixels.
+     */
+    int getHeight() const {
+        return m_height;
+    }
+
+    /**
+        Returns the distance between rows; it may be negative.
+        @return the distance between rows, in bytes.
+     */
+    int getPitch() const {
+        return m_pitch;
+    }
+
+    /**
+        Returns a row.
+        @param y row index.
+        @return pointer to the first pixel of the row.
+     */
+    Pixel *getRow(int y) const {
+        return reinterpret_cast<Pixel *>(m_data + y * m_pitch);
+    }
+
+    /**
+        Returns a pixel.
+        @param x x coordinate.
+        @param y y coordinate.
+        @return reference to the pixel.
+     */
+    Pixel &operator ()(int x, int y) const {
+        return getRow(y)[x];
+    }
+
+    /**
+        Returns the iterator to the first row.
+        @return the iterator to the first row.
+     */
+    RowIterator begin() const {
+        return RowIterator(m_data, m_pitch);
+    }
+
+    /**
+        Returns the iterator past the last row.
+        @return the iterator past the last row.
+     */
+    RowIterator end() const {
+        return RowIterator(m_data + m_height * m_pitch, m_pitch);
+    }
+
+    /**
+        Returns a pixel as an Allegro color.
+        @param x x coordinate.
+        @param y y coordinate.
+        @return the color of the pixel.
+     */
+    ALLEGRO_COLOR getColor(int x, int y) const {
+        Pixel p = getRow(y)[x];
+        return al_map_rgba(F::getRed(p), F::getGreen(p), F::getBlue(p), F::getAlpha(p));
+    }
+
+    /**
+        Sets a pixel from color components.
+        @param x x coordinate.
+        @param y y coordinate.
+        @param r red component.
+        @param g green component.
+        @param b blue component.
+        @param a alpha component.
+     */
+    void setColor(int x, int y, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) const {
+        getRow(y)[x] = F::pack(r, g, b, a);
+    }
+
+    /**
+        Calls a function for each row.
+        @param f function with the signature f(Pixel *row, int width, int y).
+     */
+    template <class Func> void forEachRow(Func f) const {
+        uint8_t *row = m_data;
+        for(int y = 0; y < m_height; ++y, row += m_pitch) {
+            f(reinterpret_cast<Pixel *>(row), m_width, y);
+        }
+    }
+
+    /**
+        Calls a function for each pixel.
+        @param f function with the signature f(Pixel &pixel).
+     */
+    template <class Func> void forEachPixel(Func f) const {
+        uint8_t *row = m_data;
+        for(int y = 0; y < m_height; ++y, row += m_pitch) {
+            Pixel *p = reinterpret_cast<Pixel *>(row);
+            for(int x = 0; x < m_width; ++x) {
+                f(p[x]);
+            }
+        }
+    }
+
+private:
+    //first row
+    uint8_t *m_data;
+
+    //geometry
+    int m_width;
+    int m_height;
+    int m_pitch;
+
+    //initializes the view from a region
+    void _set(const ALLEGRO_LOCKED_REGION *region, int width, int height) {
+        if (region && region->format == F::Format) {
+            m_data = static_cast<uint8_t *>(region->data);
+            m_width = width;
+            m_height = height;
+            m_pitch = region->pitch;
+        }
+        else {
+            m_data = nullptr;
+            m_width = 0;
+            m_height = 0;
+            m_pitch = 0;
+        }
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_PIXEL_VIEW_HPP
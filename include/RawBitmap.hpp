@@ -0,0 +1,580 @@
+#ifndef ALX_RAW_BITMAP_HPP
+#define ALX_RAW_BITMAP_HPP
+
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include "Bitmap.hpp"
+#include "File.hpp"
+#include "FileEntry.hpp"
+#include "State.hpp"
+#include "PixelOps.hpp"
+
+
+namespace alx {
+
+
+/**
+    A raw-pixel bitmap file format, for caching decoded images and loading them quickly.
+    A file consists of a 32-byte little-endian header, followed by the pixel rows in the stored pixel format,
+    either raw or compressed as a single LZ4 block. Raw rows start at offset 32 and are stored without padding,
+    so that they can be read (or memory-mapped) straight into a locked bitmap.
+    After registerFormat() is called, Bitmap::load() and Bitmap::save() handle the format through its file extension.
+    Pixels are stored as they are in the bitmap; Allegro's image loaders premultiply them by alpha by default,
+    so files are assumed to hold premultiplied pixels, which loading with ALLEGRO_NO_PREMULTIPLIED_ALPHA divides by alpha.
+    Loaded bitmaps always have the stored pixel format, as if ALLEGRO_KEEP_BITMAP_FORMAT was given.
+ */
+class RawBitmap {
+public:
+    /**
+        Compression of the pixel rows.
+     */
+    enum Compression {
+        None,
+        LZ4
+    };
+
+    /**
+        Size of the file header, in bytes.
+     */
+    static const int HeaderSize = 32;
+
+    /**
+        Registers the format with Allegro, so that bitmaps are loaded from and saved to files with the given extension.
+        Saving through Allegro uses the compression set with setDefaultCompression().
+        Bitmap::loadFromMemory() also decodes raw bitmaps in place from then on, whatever extension it is given.
+        @param ext file extension, including the dot.
+        @return true on success.
+     */
+    static bool registerFormat(const char *ext = ".alxb") {
+        Bitmap::_rawLoader() = &_loaderMemory;
+        return
+            al_register_bitmap_loader(ext, &_loader) &&
+            al_register_bitmap_loader_f(ext, &_loaderFile) &&
+            al_register_bitmap_saver(ext, &_saver) &&
+            al_register_bitmap_saver_f(ext, &_saverFile) &&
+            al_register_bitmap_identifier(ext, &_identifier);
+    }
+
+    /**
+        Returns the compression used when saving through Allegro.
+        @return the compression used when saving through Allegro.
+     */
+    static Compression getDefaultCompression() {
+        return _defaultCompression();
+    }
+
+    /**
+        Sets the compression used when saving through Allegro.
+        @param compression compression.
+     */
+    static void setDefaultCompression(Compression compression) {
+        _defaultCompression() = compression;
+    }
+
+    /**
+        Checks if a file starts with a raw bitmap header.
+        The file position is restored.
+        @param file file.
+        @return true if the file is a raw bitmap.
+     */
+    static bool isRawBitmap(File &file) {
+        char magic[4];
+        int64_t pos = al_ftell(file.get());
+        bool result = file.read(magic, 4) == 4 && memcmp(magic, "ALXB", 4) == 0;
+        al_fseek(file.get(), pos, ALLEGRO_SEEK_SET);
+        return result;
+    }
+
+    /**
+        Loads a bitmap from a file.
+        The bitmap is created with the current new bitmap flags and the stored pixel format.
+        @param file file, positioned at the header.
+        @param flags Allegro loader flags; ALLEGRO_NO_PREMULTIPLIED_ALPHA is honoured.
+        @return the bitmap; null on failure.
+     */
+    static Bitmap load(File &file, int flags = 0) {
+        return Bitmap(_load(file, flags));
+    }
+
+    /**
+        Checks if a buffer starts with a raw bitmap header.
+        @param data data.
+        @param size size of the data, in bytes.
+        @return true if the buffer holds a raw bitmap.
+     */
+    static bool isRawBitmap(const void *data, size_t size) {
+        return size >= HeaderSize && memcmp(data, "ALXB", 4) == 0;
+    }
+
+    /**
+        Loads a bitmap from memory, for example from a memory-mapped file.
+        The pixel data are copied or decompressed straight from the buffer into the locked bitmap.
+        The bitmap is created with the current new bitmap flags and the stored pixel format.
+        @param data data.
+        @param size size of the data, in bytes.
+        @param flags Allegro loader flags; ALLEGRO_NO_PREMULTIPLIED_ALPHA is honoured.
+        @return the bitmap; null on failure.
+     */
+    static Bitmap load(const void *data, size_t size, int flags = 0) {
+        return Bitmap(_load((const uint8_t *)data, size, flags));
+    }
+
+    /**
+        Loads a bitmap from a file.
+        @param filename name of the file.
+        @param flags Allegro loader flags; ALLEGRO_NO_PREMULTIPLIED_ALPHA is honoured.
+        @return the bitmap; null on failure.
+     */
+    static Bitmap load(const char *filename, int flags = 0) {
+        File file(filename, "rb");
+        return file ? load(file, flags) : Bitmap();
+    }
+
+    /**
+        Saves a bitmap to a file.
+        The bitmap's pixel format is stored, except for block-compressed formats, which are stored as ABGR_8888_LE.
+        @param file file.
+        @param bitmap bitmap.
+        @param compression compression.
+        @return true on success.
+     */
+    static bool save(File &file, const Bitmap &bitmap, Compression compression = None) {
+        if (!bitmap) return false;
+        Bitmap source = bitmap;
+        int format = source.getFormat();
+        if (al_get_pixel_block_width(format) > 1) format = ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE;
+
+        Bitmap::Lock lock(source, format, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return false;
+
+        Header header;
+        header.compression = compression;
+        header.width = lock.getWidth();
+        header.height = lock.getHeight();
+        header.format = format;
+        header.pitch = header.width * region->pixel_size;
+        size_t rowSize = header.pitch, dataSize = rowSize * header.height;
+
+        if (compression == None) {
+            header.dataSize = dataSize;
+            if (!_writeHeader(file, header)) return false;
+            if (region->pitch == (int)rowSize) {
+                return file.write(region->data, dataSize) == dataSize;
+            }
+            for(uint32_t y = 0; y < header.height; ++y) {
+                if (file.write(_row(region, y), rowSize) != rowSize) return false;
+            }
+            return true;
+        }
+
+        //compress straight from the locked region, if its rows are contiguous
+        std::vector<uint8_t> pixels;
+        const uint8_t *data = (const uint8_t *)region->data;
+        if (region->pitch != (int)rowSize) {
+            pixels.resize(dataSize);
+            for(uint32_t y = 0; y < header.height; ++y) {
+                memcpy(&pixels[rowSize * y], _row(region, y), rowSize);
+            }
+            data = pixels.data();
+        }
+        std::vector<uint8_t> packed(compressBound(dataSize));
+        header.dataSize = compress(data, dataSize, packed.data());
+        return _writeHeader(file, header) && file.write(packed.data(), header.dataSize) == header.dataSize;
+    }
+
+    /**
+        Saves a bitmap to a file.
+        @param filename name of the file.
+        @param bitmap bitmap.
+        @param compression compression.
+        @return true on success.
+     */
+    static bool save(const char *filename, const Bitmap &bitmap, Compression compression = None) {
+        File file(filename, "wb");
+        return file && save(file, bitmap, compression);
+    }
+
+    /**
+        Converts the images of a directory that Allegro can load to raw bitmaps.
+        Each output file has the name of its source file, with the extension replaced.
+        Subdirectories are not visited.
+        @param srcDir source directory.
+        @param dstDir destination directory; it must exist.
+        @param compression compression.
+        @param ext extension of the output files.
+        @return the number of files converted.
+     */
+    static size_t convertDirectory(const char *srcDir, const char *dstDir, Compression compression = LZ4, const char *ext = ".alxb") {
+        State state;
+        state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+        al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ANY);
+
+        size_t count = 0;
+        FileEntry dir(srcDir);
+        for(FileEntry entry : dir) {
+            if (!entry.isFile()) continue;
+            std::string path = entry.getPath().cstr();
+            std::string name = path.substr(path.find_last_of("/\\") + 1);
+            size_t dot = name.find_last_of('.');
+            if (dot != std::string::npos) name.erase(dot);
+
+            Bitmap bitmap(path.c_str());
+            if (!bitmap) continue;
+            std::string dst = std::string(dstDir) + "/" + name + ext;
+            if (save(dst.c_str(), bitmap, compression)) ++count;
+        }
+
+        state.restore();
+        return count;
+    }
+
+    /**
+        Returns the maximum size of the LZ4 compressed form of some data.
+        @param size size of the data.
+        @return the maximum compressed size.
+     */
+    static size_t compressBound(size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    /**
+        Compresses data as an LZ4 block.
+        @param src source data.
+        @param size size of the source data.
+        @param dst destination buffer; it must hold at least compressBound(size) bytes.
+        @return the compressed size.
+     */
+    static size_t compress(const uint8_t *src, size_t size, uint8_t *dst) {
+        const int hashBits = 16;
+        std::vector<uint32_t> table(1 << hashBits, 0);
+        size_t ip = 0, anchor = 0;
+        uint8_t *op = dst;
+
+        //the last match must start at least 12 bytes, and end at least 5 bytes, before the end
+        if (size >= 13) {
+            size_t matchLimit = size - 5, startLimit = size - 12;
+            while (ip < startLimit) {
+                uint32_t seq = _read32(src + ip);
+                uint32_t &slot = table[(seq * 2654435761u) >> (32 - hashBits)];
+                size_t ref = slot;
+                slot = (uint32_t)ip + 1;
+                if (ref == 0 || ip + 1 - ref > 65535 || _read32(src + ref - 1) != seq) {
+                    ++ip;
+                    continue;
+                }
+                --ref;
+                size_t length = 4;
+                while (ip + length < matchLimit && src[ref + length] == src[ip + length]) {
+                    ++length;
+                }
+                op = _writeSequence(op, src + anchor, ip - anchor, ip - ref, length);
+                ip += length;
+                anchor = ip;
+            }
+        }
+
+        return _writeSequence(op, src + anchor, size - anchor, 0, 0) - dst;
+    }
+
+    /**
+        Decompresses an LZ4 block.
+        @param src compressed data.
+        @param size size of the compressed data.
+        @param dst destination buffer.
+        @param dstSize expected size of the decompressed data.
+        @return true on success; false if the data is corrupt or does not decompress to exactly dstSize bytes.
+     */
+    static bool decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dstSize) {
+        size_t ip = 0, op = 0;
+        while (ip < size) {
+            uint8_t token = src[ip++];
+
+            size_t literals = token >> 4;
+            if (literals == 15 && !_readLength(src, size, ip, literals)) return false;
+            if (literals > size - ip || literals > dstSize - op) return false;
+            memcpy(dst + op, src + ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == size) break;
+
+            if (size - ip < 2) return false;
+            size_t offset = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > op) return false;
+
+            size_t length = token & 15;
+            if (length == 15 && !_readLength(src, size, ip, length)) return false;
+            length += 4;
+            if (length > dstSize - op) return false;
+            for(size_t i = 0; i < length; ++i, ++op) {
+                dst[op] = dst[op - offset];
+            }
+        }
+        return op == dstSize;
+    }
+
+private:
+    //file header
+    struct Header {
+        uint16_t compression;
+        uint32_t width;
+        uint32_t height;
+        int32_t format;
+        uint32_t pitch;
+        uint64_t dataSize;
+    };
+
+    //default compression for the registered savers
+    static Compression &_defaultCompression() {
+        static Compression compression = None;
+        return compression;
+    }
+
+    //returns a row of a locked region
+    static uint8_t *_row(const ALLEGRO_LOCKED_REGION *region, int y) {
+        return (uint8_t *)region->data + (intptr_t)y * region->pitch;
+    }
+
+    //parses the header; the layout is magic, version, compression, width, height, format, pitch, data size
+    static bool _parseHeader(const uint8_t *p, Header &header) {
+        if (memcmp(p, "ALXB", 4) != 0 || _get<uint16_t>(p + 4) != 1) return false;
+        header.compression = _get<uint16_t>(p + 6);
+        header.width = _get<uint32_t>(p + 8);
+        header.height = _get<uint32_t>(p + 12);
+        header.format = _get<int32_t>(p + 16);
+        header.pitch = _get<uint32_t>(p + 20);
+        header.dataSize = _get<uint64_t>(p + 24);
+        if (header.compression > LZ4 || header.width == 0 || header.height == 0 || !_isValidFormat(header.format)) return false;
+        uint64_t dataSize = (uint64_t)header.pitch * header.height;
+        return
+            header.pitch == (uint64_t)header.width * al_get_pixel_size(header.format) &&
+            (header.compression == None ? header.dataSize == dataSize : header.dataSize <= compressBound(dataSize));
+    }
+
+    //checks if a stored format is one that can be loaded: a concrete, non-block-compressed format;
+    //it must be checked before passing the format to Allegro, which does not validate it
+    static bool _isValidFormat(int32_t format) {
+        return
+            format >= ALLEGRO_PIXEL_FORMAT_ARGB_8888 && format < ALLEGRO_NUM_PIXEL_FORMATS &&
+            al_get_pixel_size(format) > 0 &&
+            al_get_pixel_block_width(format) == 1 && al_get_pixel_block_height(format) == 1;
+    }
+
+    //reads a little-endian value
+    template <class T> static T _get(const uint8_t *p) {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return Util::littleToNativeEndian(v);
+    }
+
+    //creates the bitmap described by a header, with the current new bitmap flags
+    static ALLEGRO_BITMAP *_create(const Header &header) {
+        State state;
+        state.retrieve(ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+        al_set_new_bitmap_format(header.format);
+        ALLEGRO_BITMAP *result = al_create_bitmap(header.width, header.height);
+        state.restore();
+        return result;
+    }
+
+    //loads a bitmap from a file; the caller owns the result
+    static ALLEGRO_BITMAP *_load(File &file, int flags) {
+        uint8_t bytes[HeaderSize];
+        Header header;
+        if (file.read(bytes, HeaderSize) != HeaderSize || !_parseHeader(bytes, header)) return nullptr;
+
+        //a truncated file must not cause a large allocation; the size is unknown for some streams
+        int64_t size = file.getSize(), pos = file.getFilePosition();
+        if (size >= 0 && pos >= 0 && (pos > size || header.dataSize > (uint64_t)(size - pos))) return nullptr;
+
+        ALLEGRO_BITMAP *result = _create(header);
+        if (!result) return nullptr;
+
+        bool ok = false;
+        {
+            Bitmap bitmap(result, false);
+            Bitmap::Lock lock(bitmap, header.format, ALLEGRO_LOCK_WRITEONLY);
+            const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+            size_t rowSize = header.pitch;
+
+            //one read straight into the locked region, if its rows are contiguous
+            if (region && header.compression == None && region->pitch == (int)rowSize) {
+                ok = file.read(region->data, header.dataSize) == header.dataSize;
+            }
+            else if (region && header.compression == None) {
+                ok = true;
+                for(uint32_t y = 0; y < header.height && ok; ++y) {
+                    ok = file.read(_row(region, y), rowSize) == rowSize;
+                }
+            }
+            else if (region) {
+                std::vector<uint8_t> packed(header.dataSize);
+                ok = file.read(packed.data(), packed.size()) == packed.size() && _decode(header, packed.data(), region);
+            }
+        }
+
+        if (!ok) {
+            al_destroy_bitmap(result);
+            return nullptr;
+        }
+        if (flags & ALLEGRO_NO_PREMULTIPLIED_ALPHA) _unpremultiply(result);
+        return result;
+    }
+
+    //loads a bitmap from memory; the caller owns the result
+    static ALLEGRO_BITMAP *_load(const uint8_t *data, size_t size, int flags) {
+        Header header;
+        if (size < HeaderSize || !_parseHeader(data, header) || header.dataSize > size - HeaderSize) return nullptr;
+        ALLEGRO_BITMAP *result = _create(header);
+        if (!result) return nullptr;
+
+        bool ok;
+        {
+            Bitmap bitmap(result, false);
+            Bitmap::Lock lock(bitmap, header.format, ALLEGRO_LOCK_WRITEONLY);
+            const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+            ok = region && _decode(header, data + HeaderSize, region);
+        }
+
+        if (!ok) {
+            al_destroy_bitmap(result);
+            return nullptr;
+        }
+        if (flags & ALLEGRO_NO_PREMULTIPLIED_ALPHA) _unpremultiply(result);
+        return result;
+    }
+
+    //divides the color components of a loaded bitmap by alpha
+    static void _unpremultiply(ALLEGRO_BITMAP *result) {
+        Bitmap bitmap(result, false);
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READWRITE);
+        PixelOps::unpremultiplyAlpha(lock);
+    }
+
+    //copies or decompresses the pixel data into a locked region
+    static bool _decode(const Header &header, const uint8_t *data, const ALLEGRO_LOCKED_REGION *region) {
+        size_t rowSize = header.pitch, dataSize = rowSize * header.height;
+        bool contiguous = region->pitch == (int)rowSize;
+
+        if (header.compression == None && contiguous) {
+            memcpy(region->data, data, dataSize);
+            return true;
+        }
+        if (header.compression == None) {
+            for(uint32_t y = 0; y < header.height; ++y) {
+                memcpy(_row(region, y), data + rowSize * y, rowSize);
+            }
+            return true;
+        }
+        if (contiguous) {
+            return decompress(data, header.dataSize, (uint8_t *)region->data, dataSize);
+        }
+        std::vector<uint8_t> pixels(dataSize);
+        if (!decompress(data, header.dataSize, pixels.data(), dataSize)) return false;
+        for(uint32_t y = 0; y < header.height; ++y) {
+            memcpy(_row(region, y), &pixels[rowSize * y], rowSize);
+        }
+        return true;
+    }
+
+    //writes the header
+    static bool _writeHeader(File &file, const Header &header) {
+        return
+            file.write("ALXB", 4) == 4 &&
+            file.write((uint16_t)1) &&
+            file.write(header.compression) &&
+            file.write(header.width) &&
+            file.write(header.height) &&
+            file.write(header.format) &&
+            file.write(header.pitch) &&
+            file.write(header.dataSize);
+    }
+
+    //reads 4 bytes
+    static uint32_t _read32(const uint8_t *p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    //reads the extra bytes of an LZ4 length
+    static bool _readLength(const uint8_t *src, size_t size, size_t &ip, size_t &length) {
+        uint8_t b;
+        do {
+            if (ip == size) return false;
+            b = src[ip++];
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+
+    //writes the extra bytes of an LZ4 length
+    static uint8_t *_writeLength(uint8_t *op, size_t length) {
+        for(; length >= 255; length -= 255) {
+            *op++ = 255;
+        }
+        *op++ = (uint8_t)length;
+        return op;
+    }
+
+    //writes an LZ4 sequence; a length of 0 writes the final literals only
+    static uint8_t *_writeSequence(uint8_t *op, const uint8_t *literals, size_t count, size_t offset, size_t length) {
+        uint8_t *token = op++;
+        *token = (uint8_t)(std::min<size_t>(count, 15) << 4);
+        if (count >= 15) op = _writeLength(op, count - 15);
+        memcpy(op, literals, count);
+        op += count;
+        if (length == 0) return op;
+        *op++ = (uint8_t)offset;
+        *op++ = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)std::min<size_t>(length - 4, 15);
+        if (length - 4 >= 15) op = _writeLength(op, length - 4 - 15);
+        return op;
+    }
+
+    //loader callback
+    static ALLEGRO_BITMAP *_loader(const char *filename, int flags) {
+        File file(filename, "rb");
+        return file ? _loaderFile(file.get(), flags) : nullptr;
+    }
+
+    //file loader callback; the bitmap's ownership passes to the caller
+    static ALLEGRO_BITMAP *_loaderFile(ALLEGRO_FILE *fp, int flags) {
+        File file(fp, false);
+        return _load(file, flags);
+    }
+
+    //memory loader for Bitmap::loadFromMemory(); the bitmap's ownership passes to the caller
+    static ALLEGRO_BITMAP *_loaderMemory(const void *data, size_t size) {
+        return isRawBitmap(data, size) ? _load((const uint8_t *)data, size, 0) : nullptr;
+    }
+
+    //saver callback
+    static bool _saver(const char *filename, ALLEGRO_BITMAP *bmp) {
+        File file(filename, "wb");
+        return file && _saverFile(file.get(), bmp);
+    }
+
+    //file saver callback
+    static bool _saverFile(ALLEGRO_FILE *fp, ALLEGRO_BITMAP *bmp) {
+        File file(fp, false);
+        return save(file, Bitmap(bmp, false), _defaultCompression());
+    }
+
+    //identifier callback
+    static bool _identifier(ALLEGRO_FILE *fp) {
+        File file(fp, false);
+        return isRawBitmap(file);
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_RAW_BITMAP_HPP
@@ -0,0 +1,313 @@
+#ifndef ALX_RENDER_TARGET_POOL_HPP
+#define ALX_RENDER_TARGET_POOL_HPP
+
+
+#include <list>
+#include <cstdint>
+#include "Bitmap.hpp"
+#include "Size.hpp"
+#include "State.hpp"
+
+
+namespace alx {
+
+
+/**
+    Pool of render target bitmaps, keyed by size, format and bitmap flags.
+    Targets are handed out as scoped Target objects, which return their bitmap to the pool when destroyed;
+    released bitmaps are reused by later requests instead of being reallocated.
+    Call endFrame() once per frame: bitmaps left unused for more than the given number of frames are freed.
+    The pool must outlive the targets it hands out.
+ */
+class RenderTargetPool {
+    //a pooled bitmap
+    struct Entry;
+
+public:
+    /**
+        A render target borrowed from the pool; the bitmap returns to the pool when the target is destroyed.
+        Targets can be moved but not copied.
+     */
+    class Target {
+    public:
+        /**
+            Null constructor.
+         */
+        Target() : m_pool(nullptr), m_entry(nullptr) {
+        }
+
+        /**
+            Move constructor.
+            @param target source target; it becomes null.
+         */
+        Target(Target &&target) : m_pool(target.m_pool), m_entry(target.m_entry) {
+            target.m_pool = nullptr;
+            target.m_entry = nullptr;
+        }
+
+        /**
+            Returns the bitmap to the pool.
+         */
+        ~Target() {
+            release();
+        }
+
+        /**
+            Move assignment.
+            @param target source target; it becomes null.
+            @return reference to this.
+         */
+        Target &operator = (Target &&target) {
+            if (this != &target) {
+                release();
+                m_pool = target.m_pool;
+                m_entry = target.m_entry;
+                target.m_pool = nullptr;
+                target.m_entry = nullptr;
+            }
+            return *this;
+        }
+
+        /**
+            Checks if the target holds a bitmap.
+            @return true if the target holds a bitmap.
+         */
+        explicit operator bool() const {
+            return m_entry != nullptr;
+        }
+
+        /**
+            Returns the bitmap.
+            @return the bitmap.
+         */
+        Bitmap &getBitmap() const {
+            return m_entry->bitmap;
+        }
+
+        /**
+            Returns the bitmap to the pool early; the target becomes null.
+         */
+        void release() {
+            if (m_entry) m_pool->_release(m_entry);
+            m_pool = nullptr;
+            m_entry = nullptr;
+        }
+
+    private:
+        RenderTargetPool *m_pool;
+        Entry *m_entry;
+
+        Target(RenderTargetPool *pool, Entry *entry) : m_pool(pool), m_entry(entry) {
+        }
+
+        Target(const Target &) = delete;
+        Target &operator = (const Target &) = delete;
+
+        friend class RenderTargetPool;
+    };
+
+    /**
+        Constructor.
+        @param maxIdleFrames number of frames a released bitmap is kept before it is freed.
+     */
+    RenderTargetPool(unsigned maxIdleFrames = 60) :
+        m_maxIdleFrames(maxIdleFrames),
+        m_frame(0),
+        m_usage(0),
+        m_peakUsage(0),
+        m_frameUsage(0),
+        m_steadyUsage(0),
+        m_allocationCount(0),
+        m_reuseCount(0)
+    {
+    }
+
+    /**
+        Returns a render target, reusing a released bitmap with the same size, format and current new bitmap flags,
+        or creating a new one.
+        A reused bitmap is cleared to transparent black, like a new one, unless clear is false,
+        in which case it keeps the pixels of its previous user.
+        @param size size of the target.
+        @param format pixel format of the target; ALLEGRO_PIXEL_FORMAT_ANY uses Allegro's default.
+        @param clear if false, a reused bitmap is not cleared; for callers that overwrite the whole target.
+        @return the target; null if the bitmap could not be created.
+     */
+    Target acquire(const Size<int> &size, int format = ALLEGRO_PIXEL_FORMAT_ANY, bool clear = true) {
+        int flags = al_get_new_bitmap_flags();
+        for(Entry &entry : m_entries) {
+            if (!entry.inUse && entry.width == size.getWidth() && entry.height == size.getHeight() && entry.format == format && entry.flags == flags) {
+                if (clear) _clear(entry.bitmap);
+                entry.inUse = true;
+                ++m_reuseCount;
+                return Target(this, &entry);
+            }
+        }
+
+        int oldFormat = al_get_new_bitmap_format();
+        al_set_new_bitmap_format(format);
+        Bitmap bitmap(size.getWidth(), size.getHeight());
+        al_set_new_bitmap_format(oldFormat);
+        if (!bitmap) return Target();
+
+        Entry entry;
+        entry.bitmap = bitmap;
+        entry.width = size.getWidth();
+        entry.height = size.getHeight();
+        entry.format = format;
+        entry.flags = flags;
+        entry.bytes = bitmap.getByteSize();
+        entry.inUse = true;
+        entry.lastUsed = m_frame;
+        m_entries.push_back(entry);
+        ++m_allocationCount;
+        m_usage += entry.bytes;
+        if (m_usage > m_peakUsage) m_peakUsage = m_usage;
+        if (m_usage > m_frameUsage) m_frameUsage = m_usage;
+        return Target(this, &m_entries.back());
+    }
+
+    /**
+        Ends a frame: frees the bitmaps left unused for more than the maximum idle frames,
+        and records the frame's memory use as the steady-state use.
+     */
+    void endFrame() {
+        ++m_frame;
+        for(std::list<Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ) {
+            if (!it->inUse && m_frame - it->lastUsed > m_maxIdleFrames) {
+                m_usage -= it->bytes;
+                it = m_entries.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        m_steadyUsage = m_frameUsage;
+        m_frameUsage = m_usage;
+    }
+
+    /**
+        Frees all released bitmaps.
+     */
+    void trim() {
+        for(std::list<Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ) {
+            if (!it->inUse) {
+                m_usage -= it->bytes;
+                it = m_entries.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+        Returns the number of bitmaps in the pool, in use or not.
+        @return the number of bitmaps in the pool.
+     */
+    size_t getCount() const {
+        return m_entries.size();
+    }
+
+    /**
+        Returns the estimated size of the pool's bitmaps, in bytes.
+        @return the estimated size of the pool's bitmaps.
+     */
+    size_t getUsage() const {
+        return m_usage;
+    }
+
+    /**
+        Returns the highest estimated size of the pool's bitmaps so far, in bytes.
+        @return the peak memory use.
+     */
+    size_t getPeakUsage() const {
+        return m_peakUsage;
+    }
+
+    /**
+        Returns the highest estimated size of the pool's bitmaps during the last frame, in bytes;
+        once the frames settle, it is the memory the pool needs.
+        @return the steady-state memory use.
+     */
+    size_t getSteadyUsage() const {
+        return m_steadyUsage;
+    }
+
+    /**
+        Returns the number of bitmaps created.
+        @return the number of bitmaps created.
+     */
+    size_t getAllocationCount() const {
+        return m_allocationCount;
+    }
+
+    /**
+        Returns the number of requests served by reusing a bitmap.
+        @return the number of reuses.
+     */
+    size_t getReuseCount() const {
+        return m_reuseCount;
+    }
+
+    /**
+        Resets the peak usage and the allocation and reuse counters.
+     */
+    void resetCounters() {
+        m_peakUsage = m_usage;
+        m_allocationCount = 0;
+        m_reuseCount = 0;
+    }
+
+private:
+    struct Entry {
+        Bitmap bitmap;
+        int width;
+        int height;
+        int format;
+        int flags;
+        size_t bytes;
+        bool inUse;
+        uint64_t lastUsed;
+    };
+
+    //settings
+    unsigned m_maxIdleFrames;
+
+    //bitmaps; a list, so that targets can point to entries
+    std::list<Entry> m_entries;
+
+    //frame counter
+    uint64_t m_frame;
+
+    //memory use
+    size_t m_usage;
+    size_t m_peakUsage;
+    size_t m_frameUsage;
+    size_t m_steadyUsage;
+
+    //counters
+    size_t m_allocationCount;
+    size_t m_reuseCount;
+
+    //returns an entry to the pool
+    void _release(Entry *entry) {
+        entry->inUse = false;
+        entry->lastUsed = m_frame;
+    }
+
+    //clears a bitmap to transparent black; the clipping rectangle left by the previous user is reset, as in a new bitmap
+    static void _clear(Bitmap &bitmap) {
+        State state;
+        state.retrieve(ALLEGRO_STATE_TARGET_BITMAP);
+        bitmap.setTarget();
+        al_reset_clipping_rectangle();
+        al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+        state.restore();
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_RENDER_TARGET_POOL_HPP
@@ -0,0 +1,321 @@
+#ifndef ALX_RESAMPLER_HPP
+#define ALX_RESAMPLER_HPP
+
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "Cpu.hpp"
+#include "Bitmap.hpp"
+#include "ImagePipeline.hpp"
+#include "WorkerPool.hpp"
+
+
+namespace alx {
+
+
+/**
+    Resizes images with a bilinear, bicubic or Lanczos-3 filter, in parallel.
+    The filter is applied as two separable passes: a horizontal pass into a float buffer,
+    then a vertical pass into the destination; each pass splits its rows into bands that are processed
+    by a pool of worker threads plus the calling thread. When downscaling, the filter is widened
+    so that every source pixel contributes. Channels are filtered independently, so bitmaps with
+    premultiplied alpha (Allegro's default) are resampled correctly.
+    It is meant for memory bitmaps; video bitmaps work too, at the cost of the lock.
+ */
+class Resampler {
+public:
+    /**
+        Filter: Bilinear (triangle, radius 1), Bicubic (Catmull-Rom, radius 2) or Lanczos (Lanczos-3, radius 3).
+     */
+    enum Filter {
+        Bilinear,
+        Bicubic,
+        Lanczos
+    };
+
+    /**
+        Constructor.
+        Starts the worker threads.
+        @param threadCount total number of threads, including the calling thread; 1 runs everything on the calling thread.
+        @param bandSize number of rows processed by a thread at a time.
+     */
+    Resampler(int threadCount = 4, int bandSize = 16) :
+        m_bandSize(std::max(bandSize, 1)),
+        m_pool(threadCount)
+    {
+    }
+
+    /**
+        Returns the number of threads, including the calling thread.
+        @return the number of threads.
+     */
+    int getThreadCount() const {
+        return m_pool.getThreadCount();
+    }
+
+    /**
+        Resamples a bitmap into another bitmap of any size.
+        Both bitmaps are locked in ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE.
+        @param dst destination bitmap.
+        @param src source bitmap; it must not be the destination.
+        @param filter filter.
+        @return true on success, false if a bitmap could not be locked.
+     */
+    bool resample(Bitmap &dst, Bitmap &src, Filter filter = Lanczos) {
+        Bitmap::Lock srcLock(src, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        Bitmap::Lock dstLock(dst, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+        const ALLEGRO_LOCKED_REGION *sr = srcLock.getLockedRegion(), *dr = dstLock.getLockedRegion();
+        if (!sr || !dr) return false;
+        ImagePipeline::Image s = {static_cast<uint8_t *>(sr->data), srcLock.getWidth(), srcLock.getHeight(), sr->pitch};
+        ImagePipeline::Image d = {static_cast<uint8_t *>(dr->data), dstLock.getWidth(), dstLock.getHeight(), dr->pitch};
+        resample(d, s, filter);
+        return true;
+    }
+
+    /**
+        Creates a resized copy of a bitmap, with the current new bitmap flags and format.
+        @param src source bitmap.
+        @param width width of the copy.
+        @param height height of the copy.
+        @param filter filter.
+        @return the copy; null on failure.
+     */
+    Bitmap resize(Bitmap &src, int width, int height, Filter filter = Lanczos) {
+        Bitmap dst(width, height);
+        if (!dst || !resample(dst, src, filter)) return Bitmap();
+        return dst;
+    }
+
+    /**
+        Resamples an image buffer into another of any size.
+        @param dst destination image.
+        @param src source image; it must not overlap the destination.
+        @param filter filter.
+     */
+    void resample(const ImagePipeline::Image &dst, const ImagePipeline::Image &src, Filter filter = Lanczos) {
+        if (dst.width <= 0 || dst.height <= 0 || src.width <= 0 || src.height <= 0) return;
+        _Weights h = _weights(src.width, dst.width, filter);
+        _Weights v = _weights(src.height, dst.height, filter);
+
+        //horizontal pass over the source rows
+        size_t stride = (size_t)dst.width * 4;
+        std::vector<float> temp(stride * src.height);
+        _dispatch(src.height, [&](int begin, int end) {
+            for(int y = begin; y < end; ++y) {
+                horizontalRow(&temp[stride * y], src.getRow(y), &h.indices[0], &h.weights[0], h.taps, dst.width);
+            }
+        });
+
+        //vertical pass into the destination rows
+        _dispatch(dst.height, [&](int begin, int end) {
+            std::vector<const float *> rows(v.taps);
+            for(int y = begin; y < end; ++y) {
+                for(int k = 0; k < v.taps; ++k) {
+                    rows[k] = &temp[stride * v.indices[y * v.taps + k]];
+                }
+                verticalRow(dst.getRow(y), &rows[0], &v.weights[y * v.taps], v.taps, dst.width);
+            }
+        });
+    }
+
+    /**
+        Filters a row of pixels horizontally into float channels.
+        @param dst destination row; n pixels of four floats each.
+        @param src source row of 4-byte pixels.
+        @param indices source pixel index of each tap; taps entries per destination pixel.
+        @param w weight of each tap; taps entries per destination pixel.
+        @param taps number of taps.
+        @param n number of destination pixels.
+     */
+    static void horizontalRow(float *dst, const uint8_t *src, const int *indices, const float *w, int taps, int n) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasSSE2()) i = _horizontalSSE2(dst, src, indices, w, taps, n);
+#endif
+        for(; i < n; ++i) {
+            float acc[4] = {0, 0, 0, 0};
+            for(int k = 0; k < taps; ++k) {
+                const uint8_t *p = src + indices[i * taps + k] * 4;
+                float wk = w[i * taps + k];
+                acc[0] += wk * p[0];
+                acc[1] += wk * p[1];
+                acc[2] += wk * p[2];
+                acc[3] += wk * p[3];
+            }
+            dst[i * 4 + 0] = acc[0];
+            dst[i * 4 + 1] = acc[1];
+            dst[i * 4 + 2] = acc[2];
+            dst[i * 4 + 3] = acc[3];
+        }
+    }
+
+    /**
+        Combines rows of float channels with weights and stores the result as bytes.
+        @param dst destination row; n pixels.
+        @param rows source rows; n pixels of four floats each.
+        @param w weight of each row.
+        @param taps number of rows.
+        @param n number of pixels.
+     */
+    static void verticalRow(uint8_t *dst, const float *const *rows, const float *w, int taps, int n) {
+        int i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _verticalAVX2(dst, rows, w, taps, n);
+        else if (Cpu::hasSSE2()) i = _verticalSSE2(dst, rows, w, taps, n);
+#endif
+        for(; i < n * 4; ++i) {
+            float acc = 0;
+            for(int k = 0; k < taps; ++k) {
+                acc += w[k] * rows[k][i];
+            }
+            dst[i] = (uint8_t)std::min(std::max((int)std::nearbyint(acc), 0), 255);
+        }
+    }
+
+private:
+    //filter taps of one axis
+    struct _Weights {
+        int taps;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    //parameters
+    int m_bandSize;
+
+    //workers
+    WorkerPool m_pool;
+
+    //returns the radius of a filter
+    static float _radius(Filter filter) {
+        switch (filter) {
+            case Bilinear: return 1;
+            case Bicubic: return 2;
+            case Lanczos: return 3;
+        }
+        return 1;
+    }
+
+    //evaluates a filter
+    static float _filter(Filter filter, float x) {
+        const float pi = 3.14159265358979f;
+        x = std::fabs(x);
+        switch (filter) {
+            case Bilinear:
+                return x < 1 ? 1 - x : 0;
+
+            case Bicubic:
+                if (x < 1) return (1.5f * x - 2.5f) * x * x + 1;
+                if (x < 2) return ((-0.5f * x + 2.5f) * x - 4) * x + 2;
+                return 0;
+
+            case Lanczos:
+                if (x < 1e-6f) return 1;
+                if (x >= 3) return 0;
+                return std::sin(pi * x) * std::sin(pi * x / 3) / (pi * pi * x * x / 3);
+        }
+        return 0;
+    }
+
+    //computes the taps for resampling an axis; indices are clamped to the edges and weights are normalized
+    static _Weights _weights(int srcSize, int dstSize, Filter filter) {
+        float scale = (float)srcSize / dstSize;
+        float filterScale = std::max(scale, 1.0f);
+        float support = _radius(filter) * filterScale;
+        _Weights result;
+        result.taps = (int)std::ceil(support * 2) + 1;
+        result.indices.resize((size_t)dstSize * result.taps);
+        result.weights.resize((size_t)dstSize * result.taps);
+        for(int i = 0; i < dstSize; ++i) {
+            float center = (i + 0.5f) * scale;
+            int first = (int)std::floor(center - support);
+            int *indices = &result.indices[(size_t)i * result.taps];
+            float *w = &result.weights[(size_t)i * result.taps];
+            float sum = 0;
+            for(int k = 0; k < result.taps; ++k) {
+                int j = first + k;
+                indices[k] = std::min(std::max(j, 0), srcSize - 1);
+                w[k] = _filter(filter, (j + 0.5f - center) / filterScale);
+                sum += w[k];
+            }
+            for(int k = 0; k < result.taps; ++k) {
+                w[k] /= sum;
+            }
+        }
+        return result;
+    }
+
+    //runs a job over rows split into bands, using the workers and the calling thread
+    template <class F> void _dispatch(int rowCount, const F &job) {
+        int bandSize = m_bandSize;
+        m_pool.run((rowCount + bandSize - 1) / bandSize, [&job, rowCount, bandSize](int band) {
+            job(band * bandSize, std::min((band + 1) * bandSize, rowCount));
+        });
+    }
+
+#ifdef ALX_X86
+
+    //SSE2 kernels; they return the number of elements processed
+
+    ALX_TARGET_SSE2 static int _horizontalSSE2(float *dst, const uint8_t *src, const int *indices, const float *w, int taps, int n) {
+        const __m128i zero = _mm_setzero_si128();
+        for(int i = 0; i < n; ++i) {
+            __m128 acc = _mm_setzero_ps();
+            for(int k = 0; k < taps; ++k) {
+                int pixel;
+                std::memcpy(&pixel, src + indices[i * taps + k] * 4, 4);
+                __m128i p = _mm_cvtsi32_si128(pixel);
+                __m128 c = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero));
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[i * taps + k]), c));
+            }
+            _mm_storeu_ps(dst + i * 4, acc);
+        }
+        return n;
+    }
+
+    ALX_TARGET_SSE2 static int _verticalSSE2(uint8_t *dst, const float *const *rows, const float *w, int taps, int n) {
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m128i c[4];
+            for(int p = 0; p < 4; ++p) {
+                __m128 acc = _mm_setzero_ps();
+                for(int k = 0; k < taps; ++k) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(rows[k] + (i + p) * 4)));
+                }
+                c[p] = _mm_cvtps_epi32(acc);
+            }
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), packed);
+        }
+        return i * 4;
+    }
+
+    //AVX2 kernels; they return the number of elements processed
+
+    ALX_TARGET_AVX2 static int _verticalAVX2(uint8_t *dst, const float *const *rows, const float *w, int taps, int n) {
+        int i = 0;
+        for(; i + 4 <= n; i += 4) {
+            __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+            for(int k = 0; k < taps; ++k) {
+                __m256 wk = _mm256_set1_ps(w[k]);
+                acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(wk, _mm256_loadu_ps(rows[k] + i * 4)));
+                acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(wk, _mm256_loadu_ps(rows[k] + i * 4 + 8)));
+            }
+            __m256i c0 = _mm256_cvtps_epi32(acc0), c1 = _mm256_cvtps_epi32(acc1);
+            __m128i lo = _mm_packs_epi32(_mm256_castsi256_si128(c0), _mm256_extracti128_si256(c0, 1));
+            __m128i hi = _mm_packs_epi32(_mm256_castsi256_si128(c1), _mm256_extracti128_si256(c1, 1));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+        return i * 4;
+    }
+
+#endif //ALX_X86
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_RESAMPLER_HPP
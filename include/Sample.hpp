@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <tuple>
+#include <cstring>
 #include "File.hpp"
 #include "SampleId.hpp"
 
@@ -117,6 +118,23 @@ public:
         return (bool)(*this);
     }
 
+    /**
+        Loads a sample from memory, for example from a memory-mapped pack.
+        Uncompressed 8-bit, 16-bit or float WAV data with one or two channels are not copied:
+        the sample plays straight out of the buffer, which must therefore outlive the sample.
+        Other formats are decoded by Allegro through a memfile over the buffer.
+        @param data data.
+        @param size size of the data, in bytes.
+        @param ext filename extension of the data's format.
+        @return true on success.
+     */
+    bool loadFromMemory(const void *data, size_t size, const char *ext = ".wav") {
+        if (_createFromWav((const uint8_t *)data, size)) return true;
+        File file((void *)data, size, "r");
+        reset(al_load_sample_f(file.get(), ext), al_destroy_sample);
+        return (bool)(*this);
+    }
+
     /**
         Saves a sample.
         @param filename filename.
@@ -145,6 +163,55 @@ public:
         Shared(object, managed, al_destroy_sample)
     {
     }
+
+private:
+    //reads a little-endian value
+    template <class T> static T _get(const uint8_t *p) {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return Util::littleToNativeEndian(v);
+    }
+
+    //wraps the PCM data of a WAV buffer, if the data can be played as they are
+    bool _createFromWav(const uint8_t *p, size_t size) {
+        if (size < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0) return false;
+        const uint8_t *fmt = nullptr, *pcm = nullptr;
+        size_t fmtSize = 0, pcmSize = 0;
+        for(size_t pos = 12; pos + 8 <= size; ) {
+            size_t chunkSize = _get<uint32_t>(p + pos + 4);
+            if (chunkSize > size - pos - 8) chunkSize = size - pos - 8;
+            if (memcmp(p + pos, "fmt ", 4) == 0) {
+                fmt = p + pos + 8;
+                fmtSize = chunkSize;
+            }
+            else if (memcmp(p + pos, "data", 4) == 0) {
+                pcm = p + pos + 8;
+                pcmSize = chunkSize;
+            }
+            pos += 8 + chunkSize + (chunkSize & 1);
+        }
+        if (!fmt || !pcm || fmtSize < 16) return false;
+
+        unsigned format = _get<uint16_t>(fmt), channels = _get<uint16_t>(fmt + 2), bits = _get<uint16_t>(fmt + 14);
+        unsigned freq = _get<uint32_t>(fmt + 4);
+        ALLEGRO_AUDIO_DEPTH depth;
+        if (format == 1 && bits == 8) depth = ALLEGRO_AUDIO_DEPTH_UINT8;
+        else if (format == 1 && bits == 16) depth = ALLEGRO_AUDIO_DEPTH_INT16;
+        else if (format == 3 && bits == 32) depth = ALLEGRO_AUDIO_DEPTH_FLOAT32;
+        else return false;
+        if (channels < 1 || channels > 2) return false;
+
+        //samples wider than a byte must be native-endian and aligned to be used in place
+        size_t sampleSize = bits / 8;
+        if (sampleSize > 1 && (!Util::isLittleEndian() || (uintptr_t)pcm % sampleSize != 0)) return false;
+
+        unsigned samples = (unsigned)(pcmSize / (sampleSize * channels));
+        ALLEGRO_CHANNEL_CONF conf = channels == 1 ? ALLEGRO_CHANNEL_CONF_1 : ALLEGRO_CHANNEL_CONF_2;
+        ALLEGRO_SAMPLE *sample = al_create_sample((void *)pcm, samples, freq, depth, conf, false);
+        if (!sample) return false;
+        reset(sample, al_destroy_sample);
+        return true;
+    }
 };
 
 
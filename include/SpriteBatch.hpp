@@ -0,0 +1,331 @@
+#ifndef ALX_SPRITE_BATCH_HPP
+#define ALX_SPRITE_BATCH_HPP
+
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <allegro5/allegro_primitives.h>
+#include "Bitmap.hpp"
+#include "Transform.hpp"
+
+
+namespace alx {
+
+
+/**
+    Collects textured quads from many bitmaps and draws them with as few primitive calls as possible.
+    Quads are grouped by the bitmap that owns the texture (sub-bitmaps are resolved to their root parent),
+    and each group is drawn with a single al_draw_indexed_prim call.
+    The bitmaps passed to the batch must stay alive until the batch is flushed.
+    Quads are transformed by the current transform at flush time, just like al_draw_bitmap.
+ */
+class SpriteBatch {
+public:
+    /**
+        Constructor.
+        @param sortByTexture if true, all quads of the same texture are drawn together;
+            drawing order is then kept only between quads of the same texture.
+            If false, only consecutive quads of the same texture are merged and drawing order is fully preserved.
+        @param reserve number of quads to reserve space for.
+     */
+    SpriteBatch(bool sortByTexture = true, size_t reserve = 0) :
+        m_sortByTexture(sortByTexture),
+        m_drawCallCount(0)
+    {
+        m_vertices.reserve(reserve * 4);
+        m_keys.reserve(reserve);
+    }
+
+    /**
+        Destructor.
+        Draws any pending quads.
+     */
+    ~SpriteBatch() {
+        flush();
+    }
+
+    /**
+        Checks if quads are grouped by texture.
+        @return true if quads are grouped by texture.
+     */
+    bool isSortedByTexture() const {
+        return m_sortByTexture;
+    }
+
+    /**
+        Sets the texture grouping mode.
+        @param sortByTexture if true, all quads of the same texture are drawn together.
+     */
+    void setSortedByTexture(bool sortByTexture) {
+        m_sortByTexture = sortByTexture;
+    }
+
+    /**
+        Returns the number of pending quads.
+        @return the number of pending quads.
+     */
+    size_t getSpriteCount() const {
+        return m_keys.size();
+    }
+
+    /**
+        Returns the number of primitive calls issued by the last flush.
+        @return the number of primitive calls issued by the last flush.
+     */
+    size_t getDrawCallCount() const {
+        return m_drawCallCount;
+    }
+
+    /**
+        Adds a bitmap.
+        @param bitmap bitmap.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void draw(const Bitmap &bitmap, float dx, float dy, int flags = 0) {
+        float w = bitmap.getWidth(), h = bitmap.getHeight();
+        _add(bitmap, _white(), 0, 0, w, h, dx, dy, w, h, flags);
+    }
+
+    /**
+        Adds part of a bitmap.
+        @param bitmap bitmap.
+        @param sx source x position.
+        @param sy source y position.
+        @param sw source width.
+        @param sh source height.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void draw(const Bitmap &bitmap, float sx, float sy, float sw, float sh, float dx, float dy, int flags = 0) {
+        _add(bitmap, _white(), sx, sy, sw, sh, dx, dy, sw, sh, flags);
+    }
+
+    /**
+        Adds a tinted bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void drawTinted(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float dx, float dy, int flags = 0) {
+        float w = bitmap.getWidth(), h = bitmap.getHeight();
+        _add(bitmap, color, 0, 0, w, h, dx, dy, w, h, flags);
+    }
+
+    /**
+        Adds part of a bitmap, tinted.
+        @param bitmap bitmap.
+        @param color color.
+        @param sx source x position.
+        @param sy source y position.
+        @param sw source width.
+        @param sh source height.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param flags flags.
+     */
+    void drawTinted(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, int flags = 0) {
+        _add(bitmap, color, sx, sy, sw, sh, dx, dy, sw, sh, flags);
+    }
+
+    /**
+        Adds a scaled bitmap.
+        @param bitmap bitmap.
+        @param sx source x.
+        @param sy source y.
+        @param sw source width.
+        @param sh source height.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawScaled(const Bitmap &bitmap, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags = 0) {
+        _add(bitmap, _white(), sx, sy, sw, sh, dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Adds a tinted scaled bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param sx source x.
+        @param sy source y.
+        @param sw source width.
+        @param sh source height.
+        @param dx destination x.
+        @param dy destination y.
+        @param dw destination width.
+        @param dh destination height.
+        @param flags same as for al_draw_bitmap.
+     */
+    void drawTintedScaled(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags = 0) {
+        _add(bitmap, color, sx, sy, sw, sh, dx, dy, dw, dh, flags);
+    }
+
+    /**
+        Adds a scaled and rotated bitmap.
+        @param bitmap bitmap.
+        @param cx center x.
+        @param cy center y.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param xscale scale along the x axis.
+        @param yscale scale along the y axis.
+        @param angle angle in radians; clockwise.
+        @param flags flags.
+     */
+    void drawScaledRotated(const Bitmap &bitmap, float cx, float cy, float dx, float dy, float xscale, float yscale, float angle, int flags = 0) {
+        drawScaledRotated(bitmap, _white(), cx, cy, dx, dy, xscale, yscale, angle, flags);
+    }
+
+    /**
+        Adds a tinted, scaled and rotated bitmap.
+        @param bitmap bitmap.
+        @param color color.
+        @param cx center x.
+        @param cy center y.
+        @param dx target horizontal position.
+        @param dy target vertical position.
+        @param xscale scale along the x axis.
+        @param yscale scale along the y axis.
+        @param angle angle in radians; clockwise.
+        @param flags flags.
+     */
+    void drawScaledRotated(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float cx, float cy, float dx, float dy, float xscale, float yscale, float angle, int flags = 0) {
+        float w = bitmap.getWidth(), h = bitmap.getHeight();
+        float c = std::cos(angle), s = std::sin(angle);
+        float m[6] = {xscale * c, -yscale * s, dx, xscale * s, yscale * c, dy};
+        _add(bitmap, color, 0, 0, w, h, -cx, -cy, w, h, flags, m);
+    }
+
+    /**
+        Adds part of a bitmap, placed with the given transform.
+        The quad spans (0, 0) to (sw, sh) before the transform is applied.
+        @param bitmap bitmap.
+        @param color tint color.
+        @param sx source x.
+        @param sy source y.
+        @param sw source width.
+        @param sh source height.
+        @param transform destination transform.
+        @param flags flags.
+     */
+    void draw(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, const Transform &transform, int flags = 0) {
+        const ALLEGRO_TRANSFORM &t = transform.get();
+        float m[6] = {t.m[0][0], t.m[1][0], t.m[3][0], t.m[0][1], t.m[1][1], t.m[3][1]};
+        _add(bitmap, color, sx, sy, sw, sh, 0, 0, sw, sh, flags, m);
+    }
+
+    /**
+        Draws all pending quads onto the target bitmap, then clears the batch.
+     */
+    void flush() {
+        m_drawCallCount = 0;
+        if (m_keys.empty()) return;
+
+        if (m_sortByTexture) {
+            std::sort(m_keys.begin(), m_keys.end());
+        }
+
+        for(size_t begin = 0; begin < m_keys.size(); ) {
+            ALLEGRO_BITMAP *texture = m_keys[begin].first;
+            m_indices.clear();
+            size_t end = begin;
+            for(; end < m_keys.size() && m_keys[end].first == texture; ++end) {
+                int v = (int)m_keys[end].second * 4;
+                m_indices.push_back(v    );
+                m_indices.push_back(v + 1);
+                m_indices.push_back(v + 2);
+                m_indices.push_back(v    );
+                m_indices.push_back(v + 2);
+                m_indices.push_back(v + 3);
+            }
+            al_draw_indexed_prim(m_vertices.data(), nullptr, texture, m_indices.data(), (int)m_indices.size(), ALLEGRO_PRIM_TRIANGLE_LIST);
+            ++m_drawCallCount;
+            begin = end;
+        }
+
+        clear();
+    }
+
+    /**
+        Discards all pending quads.
+     */
+    void clear() {
+        m_vertices.clear();
+        m_keys.clear();
+    }
+
+private:
+    //texture grouping mode
+    bool m_sortByTexture;
+
+    //four vertices per quad
+    std::vector<ALLEGRO_VERTEX> m_vertices;
+
+    //root texture and quad index, per quad
+    std::vector<std::pair<ALLEGRO_BITMAP *, unsigned>> m_keys;
+
+    //index scratch buffer
+    std::vector<int> m_indices;
+
+    //draw calls of last flush
+    size_t m_drawCallCount;
+
+    //the default tint
+    static ALLEGRO_COLOR _white() {
+        ALLEGRO_COLOR c = {1, 1, 1, 1};
+        return c;
+    }
+
+    //adds a quad; the destination rect is optionally mapped through the 2x3 matrix m
+    void _add(const Bitmap &bitmap, const ALLEGRO_COLOR &color, float sx, float sy, float sw, float sh, float dx, float dy, float dw, float dh, int flags, const float *m = nullptr) {
+        //resolve sub-bitmaps to the bitmap that owns the texture
+        ALLEGRO_BITMAP *texture = bitmap.get();
+        while (ALLEGRO_BITMAP *parent = al_get_parent_bitmap(texture)) {
+            sx += al_get_bitmap_x(texture);
+            sy += al_get_bitmap_y(texture);
+            texture = parent;
+        }
+
+        float u0 = sx, u1 = sx + sw, v0 = sy, v1 = sy + sh;
+        if (flags & ALLEGRO_FLIP_HORIZONTAL) std::swap(u0, u1);
+        if (flags & ALLEGRO_FLIP_VERTICAL) std::swap(v0, v1);
+
+        float x[4] = {dx, dx + dw, dx + dw, dx};
+        float y[4] = {dy, dy, dy + dh, dy + dh};
+        float u[4] = {u0, u1, u1, u0};
+        float v[4] = {v0, v0, v1, v1};
+
+        m_keys.push_back(std::make_pair(texture, (unsigned)m_keys.size()));
+        for(int i = 0; i < 4; ++i) {
+            ALLEGRO_VERTEX vtx;
+            if (m) {
+                vtx.x = m[0] * x[i] + m[1] * y[i] + m[2];
+                vtx.y = m[3] * x[i] + m[4] * y[i] + m[5];
+            }
+            else {
+                vtx.x = x[i];
+                vtx.y = y[i];
+            }
+            vtx.z = 0;
+            vtx.u = u[i];
+            vtx.v = v[i];
+            vtx.color = color;
+            m_vertices.push_back(vtx);
+        }
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_SPRITE_BATCH_HPP
@@ -0,0 +1,398 @@
+#ifndef ALX_TEXTURE_ATLAS_HPP
+#define ALX_TEXTURE_ATLAS_HPP
+
+
+#include <vector>
+#include <map>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include "Bitmap.hpp"
+#include "State.hpp"
+
+
+namespace alx {
+
+
+/**
+    Packs many bitmaps into a few large page bitmaps and hands out sub-bitmaps that point into the pages.
+    Bitmaps are added first, then build() packs and copies them; identical inputs are stored only once.
+    After build(), the atlas is immutable until clear() is called.
+    The pages are created with the current new bitmap flags and format.
+ */
+class TextureAtlas {
+public:
+    /**
+        Constructor.
+        @param pageWidth maximum page width.
+        @param pageHeight maximum page height.
+        @param padding empty pixels kept around each packed bitmap, to avoid bleeding when filtering.
+     */
+    TextureAtlas(int pageWidth = 2048, int pageHeight = 2048, int padding = 1) :
+        m_pageWidth(pageWidth),
+        m_pageHeight(pageHeight),
+        m_padding(padding),
+        m_built(false)
+    {
+    }
+
+    /**
+        Adds a bitmap.
+        If an identical bitmap was already added, the existing copy is shared.
+        @param bitmap bitmap to add.
+        @return index of the entry, or -1 on error or if the atlas is already built.
+     */
+    int add(const Bitmap &bitmap) {
+        if (m_built || !bitmap) return -1;
+
+        Source src;
+        src.bitmap = bitmap;
+        src.width = bitmap.getWidth();
+        src.height = bitmap.getHeight();
+        src.hash = _hash(src.bitmap, src.width, src.height);
+
+        //look for a duplicate
+        int unique = -1;
+        for(std::multimap<uint64_t, int>::const_iterator it = m_hashes.lower_bound(src.hash); it != m_hashes.end() && it->first == src.hash; ++it) {
+            if (_equal(m_sources[it->second], src)) {
+                unique = it->second;
+                break;
+            }
+        }
+
+        if (unique < 0) {
+            unique = (int)m_sources.size();
+            m_sources.push_back(src);
+            m_hashes.insert(std::make_pair(src.hash, unique));
+        }
+
+        m_entries.push_back(unique);
+        return (int)m_entries.size() - 1;
+    }
+
+    /**
+        Loads and adds a bitmap from file.
+        Adding the same filename again does not reload it.
+        @param filename filename.
+        @return index of the entry, or -1 on error or if the atlas is already built.
+     */
+    int add(const char *filename) {
+        if (m_built) return -1;
+        std::map<std::string, int>::const_iterator it = m_filenames.find(filename);
+        if (it != m_filenames.end()) {
+            m_entries.push_back(m_entries[it->second]);
+            return (int)m_entries.size() - 1;
+        }
+        int index = add(Bitmap(filename));
+        if (index >= 0) m_filenames[filename] = index;
+        return index;
+    }
+
+    /**
+        Packs all added bitmaps into pages and creates the sub-bitmaps.
+        The source bitmaps are released afterwards.
+        @return true on success.
+     */
+    bool build() {
+        if (m_built) return false;
+
+        //pack the largest bitmaps first
+        std::vector<int> order(m_sources.size());
+        for(size_t i = 0; i < order.size(); ++i) order[i] = (int)i;
+        std::sort(order.begin(), order.end(), [this](int a, int b) {
+            const Source &sa = m_sources[a], &sb = m_sources[b];
+            return sa.height > sb.height || (sa.height == sb.height && sa.width > sb.width);
+        });
+
+        std::vector<Page> pages;
+        for(int index : order) {
+            Source &src = m_sources[index];
+            int w = src.width + m_padding * 2;
+            int h = src.height + m_padding * 2;
+
+            //oversized bitmaps get a page of their own
+            if (w > m_pageWidth || h > m_pageHeight) {
+                pages.push_back(Page(w, h));
+            }
+
+            bool packed = false;
+            for(size_t p = 0; p < pages.size() && !packed; ++p) {
+                int x, y;
+                if (pages[p].insert(w, h, x, y)) {
+                    src.page = (int)p;
+                    src.x = x + m_padding;
+                    src.y = y + m_padding;
+                    packed = true;
+                }
+            }
+            if (!packed) {
+                pages.push_back(Page(m_pageWidth, m_pageHeight));
+                int x, y;
+                pages.back().insert(w, h, x, y);
+                src.page = (int)pages.size() - 1;
+                src.x = x + m_padding;
+                src.y = y + m_padding;
+            }
+        }
+
+        //create the pages, trimmed to their used extent, and copy the sources
+        State state;
+        state.retrieve(ALLEGRO_STATE_TARGET_BITMAP | ALLEGRO_STATE_BLENDER);
+        al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);
+        bool ok = true;
+        for(size_t p = 0; p < pages.size(); ++p) {
+            Bitmap page(pages[p].usedWidth, pages[p].usedHeight);
+            if (!page) {
+                ok = false;
+                break;
+            }
+            page.setTarget();
+            al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+            m_pages.push_back(page);
+        }
+        if (ok) {
+            for(Source &src : m_sources) {
+                m_pages[src.page].setTarget();
+                src.bitmap.draw(src.x, src.y);
+                src.bitmap = Bitmap();
+            }
+            for(int unique : m_entries) {
+                const Source &src = m_sources[unique];
+                m_bitmaps.push_back(Bitmap(m_pages[src.page], Point<int>(src.x, src.y), Size<int>(src.width, src.height)));
+            }
+        }
+        state.restore();
+
+        if (!ok) {
+            m_pages.clear();
+            return false;
+        }
+        m_built = true;
+        return true;
+    }
+
+    /**
+        Checks if the atlas has been built.
+        @return true if built.
+     */
+    bool isBuilt() const {
+        return m_built;
+    }
+
+    /**
+        Returns the sub-bitmap of an entry.
+        @param index entry index, as returned by add().
+        @return the sub-bitmap of the entry; null if the atlas is not built.
+     */
+    Bitmap getBitmap(int index) const {
+        return m_built ? m_bitmaps[index] : Bitmap();
+    }
+
+    /**
+        Returns the number of added entries.
+        @return the number of added entries.
+     */
+    size_t getEntryCount() const {
+        return m_entries.size();
+    }
+
+    /**
+        Returns the number of entries that were found to be duplicates.
+        @return the number of duplicate entries.
+     */
+    size_t getDuplicateCount() const {
+        return m_entries.size() - m_sources.size();
+    }
+
+    /**
+        Returns the page bitmaps.
+        @return the page bitmaps.
+     */
+    const std::vector<Bitmap> &getPages() const {
+        return m_pages;
+    }
+
+    /**
+        Returns the ratio of packed pixels to total page pixels.
+        @return packing efficiency in the range 0 to 1; 0 if not built.
+     */
+    double getPackingEfficiency() const {
+        double used = 0, total = 0;
+        for(const Source &src : m_sources) {
+            used += (double)src.width * src.height;
+        }
+        for(const Bitmap &page : m_pages) {
+            total += (double)page.getWidth() * page.getHeight();
+        }
+        return total > 0 ? used / total : 0;
+    }
+
+    /**
+        Releases all entries and pages.
+        Sub-bitmaps handed out keep their page alive.
+     */
+    void clear() {
+        m_sources.clear();
+        m_hashes.clear();
+        m_filenames.clear();
+        m_entries.clear();
+        m_pages.clear();
+        m_bitmaps.clear();
+        m_built = false;
+    }
+
+private:
+    //a unique source bitmap and its placement
+    struct Source {
+        Bitmap bitmap;
+        int width;
+        int height;
+        uint64_t hash;
+        int page;
+        int x;
+        int y;
+    };
+
+    //skyline packer for one page
+    struct Page {
+        struct Node {
+            int x, y, width;
+        };
+
+        int width;
+        int height;
+        int usedWidth;
+        int usedHeight;
+        std::vector<Node> skyline;
+
+        Page(int w, int h) : width(w), height(h), usedWidth(0), usedHeight(0) {
+            Node node = {0, 0, w};
+            skyline.push_back(node);
+        }
+
+        //finds the lowest position for a rect of the given size
+        bool insert(int w, int h, int &outX, int &outY) {
+            int bestIndex = -1, bestTop = height + 1, bestWidth = width + 1, bestY = 0;
+            for(size_t i = 0; i < skyline.size(); ++i) {
+                int y;
+                if (!_fit(i, w, h, y)) continue;
+                if (y + h < bestTop || (y + h == bestTop && skyline[i].width < bestWidth)) {
+                    bestIndex = (int)i;
+                    bestTop = y + h;
+                    bestWidth = skyline[i].width;
+                    bestY = y;
+                }
+            }
+            if (bestIndex < 0) return false;
+
+            outX = skyline[bestIndex].x;
+            outY = bestY;
+            usedWidth = std::max(usedWidth, outX + w);
+            usedHeight = std::max(usedHeight, outY + h);
+
+            //raise the skyline under the rect
+            Node node = {outX, outY + h, w};
+            skyline.insert(skyline.begin() + bestIndex, node);
+            for(size_t i = bestIndex + 1; i < skyline.size(); ) {
+                int right = skyline[i - 1].x + skyline[i - 1].width;
+                if (skyline[i].x >= right) break;
+                int shrink = right - skyline[i].x;
+                if (skyline[i].width <= shrink) {
+                    skyline.erase(skyline.begin() + i);
+                    continue;
+                }
+                skyline[i].x += shrink;
+                skyline[i].width -= shrink;
+                break;
+            }
+
+            //merge nodes of equal height
+            for(size_t i = 1; i < skyline.size(); ) {
+                if (skyline[i - 1].y == skyline[i].y) {
+                    skyline[i - 1].width += skyline[i].width;
+                    skyline.erase(skyline.begin() + i);
+                }
+                else {
+                    ++i;
+                }
+            }
+            return true;
+        }
+
+        //checks if a rect fits at the given skyline node and returns its y
+        bool _fit(size_t index, int w, int h, int &y) const {
+            if (skyline[index].x + w > width) return false;
+            y = 0;
+            int remaining = w;
+            for(size_t i = index; remaining > 0; ++i) {
+                if (i == skyline.size()) return false;
+                y = std::max(y, skyline[i].y);
+                if (y + h > height) return false;
+                remaining -= skyline[i].width;
+            }
+            return true;
+        }
+    };
+
+    //parameters
+    int m_pageWidth;
+    int m_pageHeight;
+    int m_padding;
+    bool m_built;
+
+    //unique sources
+    std::vector<Source> m_sources;
+
+    //content hash to source index
+    std::multimap<uint64_t, int> m_hashes;
+
+    //filename to entry index
+    std::map<std::string, int> m_filenames;
+
+    //entry index to source index
+    std::vector<int> m_entries;
+
+    //result
+    std::vector<Bitmap> m_pages;
+    std::vector<Bitmap> m_bitmaps;
+
+    //hashes the pixels of a bitmap (FNV-1a)
+    static uint64_t _hash(Bitmap &bitmap, int width, int height) {
+        uint64_t h = 14695981039346656037ULL;
+        h = (h ^ (uint64_t)width) * 1099511628211ULL;
+        h = (h ^ (uint64_t)height) * 1099511628211ULL;
+        Bitmap::Lock lock(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *region = lock.getLockedRegion();
+        if (!region) return h;
+        for(int y = 0; y < height; ++y) {
+            const uint8_t *row = (const uint8_t *)region->data + y * region->pitch;
+            for(int i = 0; i < width * 4; ++i) {
+                h = (h ^ row[i]) * 1099511628211ULL;
+            }
+        }
+        return h;
+    }
+
+    //compares the pixels of two sources
+    static bool _equal(const Source &a, const Source &b) {
+        if (a.bitmap == b.bitmap) return true;
+        if (a.width != b.width || a.height != b.height) return false;
+        Bitmap ba = a.bitmap, bb = b.bitmap;
+        Bitmap::Lock la(ba, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        Bitmap::Lock lb(bb, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+        const ALLEGRO_LOCKED_REGION *ra = la.getLockedRegion(), *rb = lb.getLockedRegion();
+        if (!ra || !rb) return false;
+        for(int y = 0; y < a.height; ++y) {
+            if (std::memcmp((const uint8_t *)ra->data + y * ra->pitch, (const uint8_t *)rb->data + y * rb->pitch, a.width * 4) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_TEXTURE_ATLAS_HPP
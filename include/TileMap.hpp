@@ -0,0 +1,274 @@
+#ifndef ALX_TILE_MAP_HPP
+#define ALX_TILE_MAP_HPP
+
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include "Bitmap.hpp"
+#include "Rect.hpp"
+#include "State.hpp"
+
+
+namespace alx {
+
+
+/**
+    A tile map drawn through cached chunk bitmaps.
+    Tiles are stored as 16-bit indices into a tileset bitmap, whose tiles are laid out in rows.
+    The map is split into square chunks of tiles; each chunk is baked into its own bitmap the first time it is drawn,
+    and re-baked only after one of its tiles changes. Drawing a view draws only the chunks that overlap the camera.
+    Chunk bitmaps are created with the current new bitmap flags and format.
+ */
+class TileMap {
+public:
+    /**
+        Index of an empty tile.
+     */
+    static const uint16_t Empty = 0xffff;
+
+    /**
+        Constructor.
+        All tiles are initially empty.
+        @param tileset tileset bitmap.
+        @param tileWidth width of a tile in pixels.
+        @param tileHeight height of a tile in pixels.
+        @param width width of the map in tiles.
+        @param height height of the map in tiles.
+        @param chunkSize width and height of a chunk in tiles.
+     */
+    TileMap(const Bitmap &tileset, int tileWidth, int tileHeight, int width, int height, int chunkSize = 16) :
+        m_tileset(tileset),
+        m_tileWidth(tileWidth),
+        m_tileHeight(tileHeight),
+        m_width(width),
+        m_height(height),
+        m_chunkSize(chunkSize),
+        m_chunkCols((width + chunkSize - 1) / chunkSize),
+        m_chunkRows((height + chunkSize - 1) / chunkSize),
+        m_tiles((size_t)width * height, (uint16_t)Empty),
+        m_chunks((size_t)m_chunkCols * m_chunkRows),
+        m_bakeCount(0),
+        m_drawCount(0)
+    {
+    }
+
+    /**
+        Returns the width of the map in tiles.
+        @return the width of the map in tiles.
+     */
+    int getWidth() const {
+        return m_width;
+    }
+
+    /**
+        Returns the height of the map in tiles.
+        @return the height of the map in tiles.
+     */
+    int getHeight() const {
+        return m_height;
+    }
+
+    /**
+        Returns the size of the map in pixels.
+        @return the size of the map in pixels.
+     */
+    Size<int> getPixelSize() const {
+        return Size<int>(m_width * m_tileWidth, m_height * m_tileHeight);
+    }
+
+    /**
+        Returns a tile.
+        @param x column.
+        @param y row.
+        @return the tile index; Empty if the tile is empty or the coordinates are outside the map.
+     */
+    uint16_t getTile(int x, int y) const {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height) return Empty;
+        return m_tiles[(size_t)y * m_width + x];
+    }
+
+    /**
+        Sets a tile; the chunk that contains it will be re-baked when drawn next.
+        Coordinates outside the map are ignored.
+        @param x column.
+        @param y row.
+        @param tile tile index, or Empty.
+     */
+    void setTile(int x, int y, uint16_t tile) {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height) return;
+        uint16_t &t = m_tiles[(size_t)y * m_width + x];
+        if (t == tile) return;
+        t = tile;
+        m_chunks[(size_t)(y / m_chunkSize) * m_chunkCols + x / m_chunkSize].dirty = true;
+    }
+
+    /**
+        Returns the tileset.
+        @return the tileset.
+     */
+    const Bitmap &getTileset() const {
+        return m_tileset;
+    }
+
+    /**
+        Sets the tileset; all chunks are re-baked when drawn next.
+        @param tileset new tileset; it must have the same tile size.
+     */
+    void setTileset(const Bitmap &tileset) {
+        m_tileset = tileset;
+        invalidate();
+    }
+
+    /**
+        Marks all chunks for re-baking; for example after the display was lost.
+     */
+    void invalidate() {
+        for(Chunk &chunk : m_chunks) {
+            chunk.dirty = true;
+        }
+    }
+
+    /**
+        Releases all chunk bitmaps.
+     */
+    void release() {
+        for(Chunk &chunk : m_chunks) {
+            chunk.bitmap = Bitmap();
+            chunk.dirty = true;
+        }
+    }
+
+    /**
+        Draws the part of the map seen by a camera onto the target bitmap.
+        @param camera the visible area, in map pixels.
+        @param dx horizontal target position of the camera's top-left corner.
+        @param dy vertical target position of the camera's top-left corner.
+     */
+    void draw(const Rect<float> &camera, float dx = 0, float dy = 0) {
+        int chunkWidth = m_chunkSize * m_tileWidth, chunkHeight = m_chunkSize * m_tileHeight;
+        int left = std::max(0, (int)std::floor(camera.getLeft() / chunkWidth));
+        int top = std::max(0, (int)std::floor(camera.getTop() / chunkHeight));
+
+        //the camera is inclusive, so it covers [left, right + 1); the last chunk is the one containing right + 1 - epsilon
+        int right = std::min(m_chunkCols - 1, (int)std::ceil((camera.getRight() + 1) / chunkWidth) - 1);
+        int bottom = std::min(m_chunkRows - 1, (int)std::ceil((camera.getBottom() + 1) / chunkHeight) - 1);
+
+        m_drawCount = 0;
+        Bitmap::HoldDrawing hold;
+        for(int cy = top; cy <= bottom; ++cy) {
+            for(int cx = left; cx <= right; ++cx) {
+                Chunk &chunk = m_chunks[(size_t)cy * m_chunkCols + cx];
+                if (chunk.dirty) {
+                    al_hold_bitmap_drawing(false);
+                    _bake(chunk, cx, cy);
+                    al_hold_bitmap_drawing(true);
+                }
+                if (!chunk.bitmap) continue;
+                chunk.bitmap.draw(dx + cx * chunkWidth - camera.getLeft(), dy + cy * chunkHeight - camera.getTop());
+                ++m_drawCount;
+            }
+        }
+    }
+
+    /**
+        Returns the number of chunks baked so far.
+        @return the number of chunks baked.
+     */
+    size_t getBakeCount() const {
+        return m_bakeCount;
+    }
+
+    /**
+        Returns the number of chunks drawn by the last draw call.
+        @return the number of chunks drawn.
+     */
+    size_t getDrawCount() const {
+        return m_drawCount;
+    }
+
+private:
+    //a chunk
+    struct Chunk {
+        Bitmap bitmap;
+        bool dirty;
+
+        Chunk() : dirty(true) {
+        }
+    };
+
+    //tileset and geometry
+    Bitmap m_tileset;
+    int m_tileWidth;
+    int m_tileHeight;
+    int m_width;
+    int m_height;
+    int m_chunkSize;
+    int m_chunkCols;
+    int m_chunkRows;
+
+    //tiles, row by row
+    std::vector<uint16_t> m_tiles;
+
+    //chunks, row by row
+    std::vector<Chunk> m_chunks;
+
+    //counters
+    size_t m_bakeCount;
+    size_t m_drawCount;
+
+    //draws the tiles of a chunk into its bitmap
+    void _bake(Chunk &chunk, int cx, int cy) {
+        chunk.dirty = false;
+        int x0 = cx * m_chunkSize, y0 = cy * m_chunkSize;
+        int x1 = std::min(x0 + m_chunkSize, m_width), y1 = std::min(y0 + m_chunkSize, m_height);
+
+        //empty chunks need no bitmap
+        bool empty = true;
+        for(int y = y0; y < y1 && empty; ++y) {
+            for(int x = x0; x < x1 && empty; ++x) {
+                empty = m_tiles[(size_t)y * m_width + x] == Empty;
+            }
+        }
+        if (empty) {
+            chunk.bitmap = Bitmap();
+            return;
+        }
+
+        if (!chunk.bitmap) {
+            chunk.bitmap = Bitmap(m_chunkSize * m_tileWidth, m_chunkSize * m_tileHeight);
+            if (!chunk.bitmap) return;
+        }
+
+        State state;
+        state.retrieve(ALLEGRO_STATE_TARGET_BITMAP | ALLEGRO_STATE_BLENDER | ALLEGRO_STATE_TRANSFORM);
+        chunk.bitmap.setTarget();
+        ALLEGRO_TRANSFORM identity;
+        al_identity_transform(&identity);
+        al_use_transform(&identity);
+        al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);
+        al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+        int tilesPerRow = std::max(1, m_tileset.getWidth() / m_tileWidth);
+        {
+            Bitmap::HoldDrawing hold;
+            for(int y = y0; y < y1; ++y) {
+                for(int x = x0; x < x1; ++x) {
+                    uint16_t tile = m_tiles[(size_t)y * m_width + x];
+                    if (tile == Empty) continue;
+                    m_tileset.draw(
+                        (float)(tile % tilesPerRow * m_tileWidth), (float)(tile / tilesPerRow * m_tileHeight), (float)m_tileWidth, (float)m_tileHeight,
+                        (float)((x - x0) * m_tileWidth), (float)((y - y0) * m_tileHeight));
+                }
+            }
+        }
+        state.restore();
+        ++m_bakeCount;
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_TILE_MAP_HPP
@@ -2,7 +2,10 @@
 #define ALX_TRANSFORM_HPP
 
 
+#include <algorithm>
+#include <type_traits>
 #include <allegro5/allegro.h>
+#include "Cpu.hpp"
 #include "Value.hpp"
 #include "Point.hpp"
 #include "Rect.hpp"
@@ -85,11 +88,73 @@ public:
 
     /**
         Transforms a rectangle.
+        The result is the axis-aligned bounding box of the four transformed corners,
+        so that rotated rectangles are bounded correctly.
         @param rt rectangle.
      */
     void transform(Rect<float> &rt) const {
-        transform(rt.m_left, rt.m_top);
-        transform(rt.m_right, rt.m_bottom);
+        transformBatch(&rt, 1);
+    }
+
+    /**
+        Transforms an array of points, using SIMD kernels when available.
+        @param pts points.
+        @param count number of points.
+     */
+    void transformBatch(Point<float> *pts, size_t count) const {
+        const ALLEGRO_TRANSFORM &t = get();
+        size_t i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _transformPointsAVX(t, &pts->m_x, count);
+        else if (Cpu::hasSSE2()) i = _transformPointsSSE(t, &pts->m_x, count);
+#endif
+        for(; i < count; ++i) {
+            _transform(t, pts[i].m_x, pts[i].m_y);
+        }
+    }
+
+    /**
+        Transforms coordinates stored as separate arrays, using SIMD kernels when available.
+        @param x horizontal coordinates.
+        @param y vertical coordinates.
+        @param count number of coordinates.
+     */
+    void transformBatch(float *x, float *y, size_t count) const {
+        const ALLEGRO_TRANSFORM &t = get();
+        size_t i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasAVX2()) i = _transformArraysAVX(t, x, y, count);
+        else if (Cpu::hasSSE2()) i = _transformArraysSSE(t, x, y, count);
+#endif
+        for(; i < count; ++i) {
+            _transform(t, x[i], y[i]);
+        }
+    }
+
+    /**
+        Transforms an array of rectangles, using SIMD kernels when available.
+        Each rectangle becomes the axis-aligned bounding box of its four transformed corners.
+        @param rects rectangles.
+        @param count number of rectangles.
+     */
+    void transformBatch(Rect<float> *rects, size_t count) const {
+        const ALLEGRO_TRANSFORM &t = get();
+        size_t i = 0;
+#ifdef ALX_X86
+        if (Cpu::hasSSE2()) i = _transformRectsSSE(t, &rects->m_left, count);
+#endif
+        for(; i < count; ++i) {
+            Rect<float> &r = rects[i];
+            float x[4] = {r.m_left, r.m_right, r.m_left, r.m_right};
+            float y[4] = {r.m_top, r.m_top, r.m_bottom, r.m_bottom};
+            for(int k = 0; k < 4; ++k) {
+                _transform(t, x[k], y[k]);
+            }
+            r.m_left = std::min(std::min(x[0], x[1]), std::min(x[2], x[3]));
+            r.m_right = std::max(std::max(x[0], x[1]), std::max(x[2], x[3]));
+            r.m_top = std::min(std::min(y[0], y[1]), std::min(y[2], y[3]));
+            r.m_bottom = std::max(std::max(y[0], y[1]), std::max(y[2], y[3]));
+        }
     }
 
     /**
@@ -154,18 +219,121 @@ public:
 
     /**
         returns the current transform.
-        @return the current transform.
+        @return the current transform; null if a TransformStack has uploaded its own transform since.
      */
     static Transform *getCurrent() {
         return _currentTransform();
     }
 
 private:
+    friend class TransformStack;
+
     //internal current transform
     static Transform*& _currentTransform() {
         static Transform *t = 0;
         return t;
     }
+
+    //transforms coordinates in 2d, like al_transform_coordinates
+    static void _transform(const ALLEGRO_TRANSFORM &t, float &x, float &y) {
+        float tx = t.m[0][0] * x + t.m[1][0] * y + t.m[3][0];
+        y = t.m[0][1] * x + t.m[1][1] * y + t.m[3][1];
+        x = tx;
+    }
+
+#ifdef ALX_X86
+
+    //the kernels access arrays of points and rectangles as packed arrays of floats
+    static_assert(std::is_standard_layout<Point<float>>::value && sizeof(Point<float>) == 2 * sizeof(float), "Point<float> must consist of two packed floats");
+    static_assert(std::is_standard_layout<Rect<float>>::value && sizeof(Rect<float>) == 4 * sizeof(float), "Rect<float> must consist of four packed floats");
+
+    //SSE kernels; they return the number of elements processed
+
+    //interleaved x, y pairs: v' = a * v + b * swap(v) + c
+    ALX_TARGET_SSE2 static size_t _transformPointsSSE(const ALLEGRO_TRANSFORM &t, float *p, size_t count) {
+        const __m128 a = _mm_setr_ps(t.m[0][0], t.m[1][1], t.m[0][0], t.m[1][1]);
+        const __m128 b = _mm_setr_ps(t.m[1][0], t.m[0][1], t.m[1][0], t.m[0][1]);
+        const __m128 c = _mm_setr_ps(t.m[3][0], t.m[3][1], t.m[3][0], t.m[3][1]);
+        size_t i = 0;
+        for(; i + 2 <= count; i += 2) {
+            __m128 v = _mm_loadu_ps(p + i * 2);
+            __m128 s = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_ps(p + i * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, v), _mm_mul_ps(b, s)), c));
+        }
+        return i;
+    }
+
+    ALX_TARGET_SSE2 static size_t _transformArraysSSE(const ALLEGRO_TRANSFORM &t, float *x, float *y, size_t count) {
+        const __m128 m00 = _mm_set1_ps(t.m[0][0]), m10 = _mm_set1_ps(t.m[1][0]), m30 = _mm_set1_ps(t.m[3][0]);
+        const __m128 m01 = _mm_set1_ps(t.m[0][1]), m11 = _mm_set1_ps(t.m[1][1]), m31 = _mm_set1_ps(t.m[3][1]);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4) {
+            __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i);
+            _mm_storeu_ps(x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, vx), _mm_mul_ps(m10, vy)), m30));
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, vx), _mm_mul_ps(m11, vy)), m31));
+        }
+        return i;
+    }
+
+    //four rectangles at a time, transposed to left, top, right and bottom vectors
+    ALX_TARGET_SSE2 static size_t _transformRectsSSE(const ALLEGRO_TRANSFORM &t, float *r, size_t count) {
+        const __m128 m00 = _mm_set1_ps(t.m[0][0]), m10 = _mm_set1_ps(t.m[1][0]), m30 = _mm_set1_ps(t.m[3][0]);
+        const __m128 m01 = _mm_set1_ps(t.m[0][1]), m11 = _mm_set1_ps(t.m[1][1]), m31 = _mm_set1_ps(t.m[3][1]);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4) {
+            __m128 l = _mm_loadu_ps(r + i * 4), tp = _mm_loadu_ps(r + i * 4 + 4);
+            __m128 rt = _mm_loadu_ps(r + i * 4 + 8), b = _mm_loadu_ps(r + i * 4 + 12);
+            _MM_TRANSPOSE4_PS(l, tp, rt, b);
+
+            //the products of each coordinate are shared by two corners
+            __m128 xl = _mm_mul_ps(m00, l), xr = _mm_mul_ps(m00, rt), xt = _mm_mul_ps(m10, tp), xb = _mm_mul_ps(m10, b);
+            __m128 yl = _mm_mul_ps(m01, l), yr = _mm_mul_ps(m01, rt), yt = _mm_mul_ps(m11, tp), yb = _mm_mul_ps(m11, b);
+            __m128 x0 = _mm_add_ps(_mm_add_ps(xl, xt), m30), x1 = _mm_add_ps(_mm_add_ps(xr, xt), m30);
+            __m128 x2 = _mm_add_ps(_mm_add_ps(xl, xb), m30), x3 = _mm_add_ps(_mm_add_ps(xr, xb), m30);
+            __m128 y0 = _mm_add_ps(_mm_add_ps(yl, yt), m31), y1 = _mm_add_ps(_mm_add_ps(yr, yt), m31);
+            __m128 y2 = _mm_add_ps(_mm_add_ps(yl, yb), m31), y3 = _mm_add_ps(_mm_add_ps(yr, yb), m31);
+
+            l = _mm_min_ps(_mm_min_ps(x0, x1), _mm_min_ps(x2, x3));
+            rt = _mm_max_ps(_mm_max_ps(x0, x1), _mm_max_ps(x2, x3));
+            tp = _mm_min_ps(_mm_min_ps(y0, y1), _mm_min_ps(y2, y3));
+            b = _mm_max_ps(_mm_max_ps(y0, y1), _mm_max_ps(y2, y3));
+            _MM_TRANSPOSE4_PS(l, tp, rt, b);
+            _mm_storeu_ps(r + i * 4, l);
+            _mm_storeu_ps(r + i * 4 + 4, tp);
+            _mm_storeu_ps(r + i * 4 + 8, rt);
+            _mm_storeu_ps(r + i * 4 + 12, b);
+        }
+        return i;
+    }
+
+    //AVX kernels; they return the number of elements processed
+
+    ALX_TARGET_AVX2 static size_t _transformPointsAVX(const ALLEGRO_TRANSFORM &t, float *p, size_t count) {
+        const __m256 a = _mm256_setr_ps(t.m[0][0], t.m[1][1], t.m[0][0], t.m[1][1], t.m[0][0], t.m[1][1], t.m[0][0], t.m[1][1]);
+        const __m256 b = _mm256_setr_ps(t.m[1][0], t.m[0][1], t.m[1][0], t.m[0][1], t.m[1][0], t.m[0][1], t.m[1][0], t.m[0][1]);
+        const __m256 c = _mm256_setr_ps(t.m[3][0], t.m[3][1], t.m[3][0], t.m[3][1], t.m[3][0], t.m[3][1], t.m[3][0], t.m[3][1]);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4) {
+            __m256 v = _mm256_loadu_ps(p + i * 2);
+            __m256 s = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm256_storeu_ps(p + i * 2, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, v), _mm256_mul_ps(b, s)), c));
+        }
+        return i;
+    }
+
+    ALX_TARGET_AVX2 static size_t _transformArraysAVX(const ALLEGRO_TRANSFORM &t, float *x, float *y, size_t count) {
+        const __m256 m00 = _mm256_set1_ps(t.m[0][0]), m10 = _mm256_set1_ps(t.m[1][0]), m30 = _mm256_set1_ps(t.m[3][0]);
+        const __m256 m01 = _mm256_set1_ps(t.m[0][1]), m11 = _mm256_set1_ps(t.m[1][1]), m31 = _mm256_set1_ps(t.m[3][1]);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8) {
+            __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i);
+            _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, vx), _mm256_mul_ps(m10, vy)), m30));
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, vx), _mm256_mul_ps(m11, vy)), m31));
+        }
+        return i;
+    }
+
+#endif //ALX_X86
 };
 
 
@@ -0,0 +1,203 @@
+#ifndef ALX_TRANSFORM_STACK_HPP
+#define ALX_TRANSFORM_STACK_HPP
+
+
+#include <vector>
+#include <cstring>
+#include "Transform.hpp"
+
+
+namespace alx {
+
+
+/**
+    A stack of composed transforms for nested drawing.
+    Each stack entry holds the full composition of the transforms pushed so far, so popping restores
+    the parent's matrix without recomposing it. Changes are not uploaded until apply() is called,
+    and apply() skips al_use_transform when the target bitmap already uses the same matrix.
+ */
+class TransformStack {
+public:
+    /**
+        Helper class that pushes a stack on construction, and pops and applies it on destruction.
+     */
+    class Scope {
+    public:
+        /**
+            Pushes the stack.
+            @param stack stack.
+         */
+        Scope(TransformStack &stack) : m_stack(stack) {
+            m_stack.push();
+        }
+
+        /**
+            Pops the stack and applies the restored transform.
+         */
+        ~Scope() {
+            m_stack.pop();
+            m_stack.apply();
+        }
+
+    private:
+        TransformStack &m_stack;
+
+        Scope(const Scope &) = delete;
+        Scope &operator = (const Scope &) = delete;
+    };
+
+    /**
+        Constructor.
+        The stack starts with the identity transform.
+     */
+    TransformStack() :
+        m_stack(1, Transform(true)),
+        m_uploadCount(0),
+        m_skipCount(0)
+    {
+    }
+
+    /**
+        Pushes a copy of the top transform.
+     */
+    void push() {
+        m_stack.push_back(m_stack.back());
+    }
+
+    /**
+        Pops the top transform; the bottom transform is never popped.
+     */
+    void pop() {
+        if (m_stack.size() > 1) m_stack.pop_back();
+    }
+
+    /**
+        Returns the number of transforms in the stack.
+        @return the depth of the stack.
+     */
+    size_t getDepth() const {
+        return m_stack.size();
+    }
+
+    /**
+        Returns the top transform, i.e. the composition of the transforms pushed so far.
+        @return the top transform.
+     */
+    const Transform &getTop() const {
+        return m_stack.back();
+    }
+
+    /**
+        Replaces the top transform.
+        @param transform new transform.
+     */
+    void set(const Transform &transform) {
+        al_copy_transform(&m_stack.back().get(), &transform.get());
+    }
+
+    /**
+        Sets the top transform to the identity.
+     */
+    void setIdentity() {
+        m_stack.back().setIdentity();
+    }
+
+    /**
+        Composes a local transform with the top transform: the local transform applies first,
+        then the transforms below it.
+        @param transform local transform.
+     */
+    void multiply(const Transform &transform) {
+        ALLEGRO_TRANSFORM t = transform.get();
+        al_compose_transform(&t, &m_stack.back().get());
+        al_copy_transform(&m_stack.back().get(), &t);
+    }
+
+    /**
+        Composes a local translation with the top transform.
+        @param x translation along the x axis.
+        @param y translation along the y axis.
+     */
+    void translate(float x, float y) {
+        Transform t(true);
+        t.translate(x, y);
+        multiply(t);
+    }
+
+    /**
+        Composes a local rotation with the top transform.
+        @param theta rotation angle.
+     */
+    void rotate(float theta) {
+        Transform t(true);
+        t.rotate(theta);
+        multiply(t);
+    }
+
+    /**
+        Composes a local scaling with the top transform.
+        @param sx scale along the x axis.
+        @param sy scale along the y axis.
+     */
+    void scale(float sx, float sy) {
+        Transform t(true);
+        t.scale(sx, sy);
+        multiply(t);
+    }
+
+    /**
+        Uses the top transform for the target bitmap, unless the target already uses the same matrix.
+        An upload replaces any transform set by Transform::setCurrent(), so Transform::getCurrent() returns null after it.
+        @return true if the transform was uploaded, false if the upload was skipped.
+     */
+    bool apply() {
+        const ALLEGRO_TRANSFORM *current = al_get_current_transform();
+        const ALLEGRO_TRANSFORM &top = m_stack.back().get();
+        if (current && memcmp(current, &top, sizeof(ALLEGRO_TRANSFORM)) == 0) {
+            ++m_skipCount;
+            return false;
+        }
+        al_use_transform(&top);
+        Transform::_currentTransform() = nullptr;
+        ++m_uploadCount;
+        return true;
+    }
+
+    /**
+        Returns the number of times apply() uploaded a transform.
+        @return the number of uploads.
+     */
+    size_t getUploadCount() const {
+        return m_uploadCount;
+    }
+
+    /**
+        Returns the number of times apply() skipped an upload because the matrix had not changed.
+        @return the number of uploads avoided.
+     */
+    size_t getSkipCount() const {
+        return m_skipCount;
+    }
+
+    /**
+        Resets the upload counters.
+     */
+    void resetCounters() {
+        m_uploadCount = 0;
+        m_skipCount = 0;
+    }
+
+private:
+    //composed transforms
+    std::vector<Transform> m_stack;
+
+    //counters
+    size_t m_uploadCount;
+    size_t m_skipCount;
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_TRANSFORM_STACK_HPP
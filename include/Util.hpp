@@ -32,7 +32,7 @@ public:
             T v;
             uint8_t b[sizeof(T)];
         } r = {v};
-        for(int i = 0; i < sizeof(T)/2; ++i) {
+        for(size_t i = 0; i < sizeof(T)/2; ++i) {
             std::swap(r.b[i], r.b[sizeof(T) - 1 - i]);
         }
         return r.v;
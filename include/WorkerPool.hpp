@@ -0,0 +1,139 @@
+#ifndef ALX_WORKER_POOL_HPP
+#define ALX_WORKER_POOL_HPP
+
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "Thread.hpp"
+#include "Condition.hpp"
+
+
+namespace alx {
+
+
+/**
+    A pool of worker threads that runs a job over a number of work items, together with the calling thread.
+    Items are handed out one at a time from a shared counter, so faster threads take more of them;
+    run() returns when all items are processed. Used by ImagePipeline (tiles) and Resampler (row bands).
+ */
+class WorkerPool {
+public:
+    /**
+        Constructor.
+        Starts the worker threads.
+        @param threadCount total number of threads, including the calling thread; 1 runs everything on the calling thread.
+     */
+    WorkerPool(int threadCount = 4) :
+        m_stop(false),
+        m_generation(0),
+        m_finished(0),
+        m_workerCount(std::max(threadCount, 1) - 1),
+        m_itemCount(0)
+    {
+        for(int i = 0; i < m_workerCount; ++i) {
+            m_threads.push_back(Thread([this]() { return _work(); }));
+            m_threads.back().start();
+        }
+    }
+
+    /**
+        Destructor.
+        Stops the worker threads.
+     */
+    ~WorkerPool() {
+        m_mutex.lock();
+        m_stop = true;
+        m_start.wakeAll();
+        m_mutex.unlock();
+        for(Thread &thread : m_threads) {
+            thread.wait();
+        }
+    }
+
+    /**
+        Returns the number of threads, including the calling thread.
+        @return the number of threads.
+     */
+    int getThreadCount() const {
+        return m_workerCount + 1;
+    }
+
+    /**
+        Runs a job over work items, using the workers and the calling thread; returns when all items are processed.
+        The job is called concurrently for different items.
+        @param itemCount number of items.
+        @param job job; called with each item index from 0 to itemCount - 1.
+     */
+    void run(int itemCount, const std::function<void(int)> &job) {
+        m_job = job;
+        m_itemCount = itemCount;
+        m_nextItem = 0;
+        if (m_workerCount > 0) {
+            Lock<Mutex> lock(m_mutex);
+            m_finished = 0;
+            ++m_generation;
+            m_start.wakeAll();
+        }
+        _runItems();
+        if (m_workerCount > 0) {
+            Lock<Mutex> lock(m_mutex);
+            while (m_finished < m_workerCount) {
+                m_done.wait(m_mutex);
+            }
+        }
+    }
+
+private:
+    //workers
+    std::vector<Thread> m_threads;
+    Mutex m_mutex;
+    Condition m_start;
+    Condition m_done;
+    bool m_stop;
+    unsigned m_generation;
+    int m_finished;
+    int m_workerCount;
+
+    //current job
+    std::function<void(int)> m_job;
+    int m_itemCount;
+    std::atomic<int> m_nextItem;
+
+    //the threads keep a pointer to the pool
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator = (const WorkerPool &) = delete;
+
+    //processes items until none are left
+    void _runItems() {
+        for(int i = m_nextItem++; i < m_itemCount; i = m_nextItem++) {
+            m_job(i);
+        }
+    }
+
+    //worker thread loop
+    void *_work() {
+        unsigned seen = 0;
+        for(;;) {
+            {
+                Lock<Mutex> lock(m_mutex);
+                while (m_generation == seen && !m_stop) {
+                    m_start.wait(m_mutex);
+                }
+                if (m_stop) break;
+                seen = m_generation;
+            }
+            _runItems();
+            Lock<Mutex> lock(m_mutex);
+            if (++m_finished == m_workerCount) m_done.wakeOne();
+        }
+        return nullptr;
+    }
+};
+
+
+} //namespace alx
+
+
+#endif //ALX_WORKER_POOL_HPP
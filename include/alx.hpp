@@ -4,12 +4,19 @@
 
 #include "AudioStream.hpp"
 #include "Bitmap.hpp"
+#include "BitmapCache.hpp"
+#include "BitmapLoader.hpp"
+#include "BitmapPyramid.hpp"
+#include "CollisionMask.hpp"
 #include "Color.hpp"
 #include "Condition.hpp"
 #include "Config.hpp"
 #include "ConfigEntryContainer.hpp"
 #include "ConfigSectionContainer.hpp"
+#include "Cpu.hpp"
+#include "DirtyRegion.hpp"
 #include "Display.hpp"
+#include "DrawList.hpp"
 #include "Event.hpp"
 #include "EventQueue.hpp"
 #include "EventSource.hpp"
@@ -18,6 +25,11 @@
 #include "FilePath.hpp"
 #include "Fixed.hpp"
 #include "Font.hpp"
+#include "FrameRecorder.hpp"
+#include "FrameStats.hpp"
+#include "HeadlessDisplay.hpp"
+#include "ImagePipeline.hpp"
+#include "IndexedBitmap.hpp"
 #include "Joystick.hpp"
 #include "JoystickState.hpp"
 #include "Keyboard.hpp"
@@ -29,26 +41,38 @@
 #include "Mutex.hpp"
 #include "NativeFileDialog.hpp"
 #include "NativeTextLog.hpp"
+#include "NinePatch.hpp"
+#include "ParticleSystem.hpp"
+#include "PixelOps.hpp"
+#include "PixelView.hpp"
 #include "Point.hpp"
+#include "RawBitmap.hpp"
 #include "Rect.hpp"
+#include "RenderTargetPool.hpp"
+#include "Resampler.hpp"
 #include "Sample.hpp"
 #include "SampleId.hpp"
 #include "SampleInstance.hpp"
 #include "Shared.hpp"
 #include "Size.hpp"
+#include "SpriteBatch.hpp"
 #include "State.hpp"
 #include "String.hpp"
 #include "System.hpp"
+#include "TextureAtlas.hpp"
 #include "Thread.hpp"
+#include "TileMap.hpp"
 #include "Timeout.hpp"
 #include "Timer.hpp"
 #include "Transform.hpp"
+#include "TransformStack.hpp"
 #include "UserEvent.hpp"
 #include "UserEventSource.hpp"
 #include "Util.hpp"
 #include "Value.hpp"
 #include "VertexDecl.hpp"
 #include "Voice.hpp"
+#include "WorkerPool.hpp"
 
 
 #endif //ALX_HPP